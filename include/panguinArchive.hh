@@ -0,0 +1,45 @@
+#ifndef panguinArchive_h
+#define panguinArchive_h
+
+#include <TFile.h>
+#include <TVirtualPad.h>
+#include <vector>
+#include <deque>
+#include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+class ArchiveWriter {
+  // ROOT file with copies of everything drawn in batch mode, one directory
+  // per pad ("page01/pad02"). The drawing thread only copies the pad
+  // primitives; compressing and writing them is done by a background
+  // thread, so that it overlaps with drawing the next pages.
+public:
+  explicit ArchiveWriter( const std::string& file, Int_t compression = -1 );
+  ~ArchiveWriter();
+
+  bool  IsOpen() const { return fFile != nullptr; }
+  const char* GetName() const { return fName.c_str(); }
+  void  AddPad( const std::string& dir, TVirtualPad* pad );
+  Int_t Close();
+
+private:
+  struct Item {
+    std::string dir;                                // Destination directory
+    std::vector<std::unique_ptr<TObject>> objects;  // Copies to write
+  };
+  void Run();
+
+  std::string             fName;
+  std::unique_ptr<TFile>  fFile;
+  std::thread             fThread;
+  std::mutex              fMutex;
+  std::condition_variable fCond;
+  std::deque<Item>        fQueue;     // Pads waiting to be written
+  bool                    fDone{false};
+  Int_t                   fNwritten{0};
+};
+
+#endif //panguinArchive_h
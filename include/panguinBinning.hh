@@ -0,0 +1,51 @@
+#ifndef panguinBinning_h
+#define panguinBinning_h
+
+#include <TH1.h>
+#include <TString.h>
+#include "panguinFormula.hh"
+#include <string>
+#include <map>
+
+struct Binning {
+  // Fixed axis binning of a 1D or 2D histogram
+  Binning() : nbins{0, 0}, lo{0, 0}, hi{0, 0} {}
+
+  bool IsValid() const { return ndim > 0; }
+  bool SameAs( const Binning& rhs ) const;
+  TH1* Book( const char* name, const char* title ) const;
+
+  Int_t    ndim{0};
+  Int_t    nbins[2];
+  Double_t lo[2];
+  Double_t hi[2];
+  std::string source;   // Where the binning came from
+};
+
+class BinningResolver {
+  // Frozen binning of tree draw histograms. The binning of each plot is
+  // determined once and then kept, so that successive updates and runs
+  // give histograms that can be filled incrementally and compared bin by
+  // bin. The binning is taken from, in order: the histogram of the same
+  // name in the golden file, the binning the plot had before (in this
+  // session or, with a cache file, in an earlier run), or the quantiles of
+  // the first entries of the tree.
+public:
+  explicit BinningResolver( std::string file = std::string() );
+
+  const Binning* Find( const std::string& key ) const;
+  const Binning& Resolve( const std::string& key, TreeExpr* expr,
+                          const TH1* golden );
+  static Binning FromHist( const TH1* hist );
+  static Binning FromSample( TreeExpr* expr );
+  const std::string& GetFile() const { return fFile; }
+
+private:
+  void Load();
+  void Save() const;
+
+  std::string fFile;                     // Cache file, empty if none
+  std::map<std::string, Binning> fBinning;  // Frozen binning by plot
+};
+
+#endif //panguinBinning_h
@@ -0,0 +1,60 @@
+#ifndef panguinBudget_h
+#define panguinBudget_h
+
+#include <TStopwatch.h>
+#include <map>
+#include <string>
+#include <utility>
+#include <ostream>
+
+// Real time elapsed on 'clock', which keeps running
+inline Double_t Elapsed( TStopwatch& clock )
+{
+  Double_t t = clock.RealTime();
+  clock.Continue();
+  return t;
+}
+
+class DrawBudget {
+  // Time budgets for drawing a pad and a whole page. Tree draws are
+  // stopped cooperatively when the time left runs out (see ProgressiveFill).
+  // Pads that exceed the pad budget are degraded: tree draws are filled from
+  // a sample of the entries the next time, other pads are redrawn only
+  // every few monitor updates and show their previous contents in between.
+  // Pads that are fast enough again are restored step by step.
+public:
+  DrawBudget( Double_t padtime, Double_t pagetime );  // seconds, 0 = no limit
+
+  void     StartPage();
+  bool     Skip( Int_t page, Int_t pad );
+  void     StartPad( Int_t page, Int_t pad );
+  Double_t GetTimeLeft();
+  Double_t GetFraction( Int_t page, Int_t pad ) const;
+  void     SetTreeDrawn( Double_t fraction, bool stopped );
+  bool     EndPad();
+  std::string GetStatus( Int_t page, Int_t pad ) const;
+  void     Report( std::ostream& os ) const;
+
+private:
+  typedef std::pair<Int_t, Int_t> Key_t;  // page, pad
+  struct PadState {
+    Double_t time{0};      // Duration of last draw (s)
+    Double_t fraction{1};  // Fraction of tree entries to draw
+    Int_t    cadence{1};   // Redraw every N-th update
+    Int_t    skipped{0};   // Updates skipped since last redraw
+    Int_t    ndraw{0};     // Number of draws
+    Int_t    nover{0};     // Number of draws over budget
+    bool     over{false};  // Last draw over budget
+    bool     cut{false};   // Last tree draw stopped early
+  };
+  Double_t   fPadTime;     // Pad budget (s)
+  Double_t   fPageTime;    // Page budget (s)
+  TStopwatch fPageClock;
+  TStopwatch fPadClock;
+  Key_t      fCurrent;     // Pad being drawn
+  Double_t   fDrawn{-1};   // Fraction of entries drawn in current pad (-1 = no tree)
+  bool       fStopped{false}; // Tree draw in current pad stopped early
+  std::map<Key_t, PadState> fPads;
+};
+
+#endif //panguinBudget_h
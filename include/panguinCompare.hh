@@ -0,0 +1,37 @@
+#ifndef panguinCompare_h
+#define panguinCompare_h
+
+#include <TH1.h>
+#include <string>
+#include <vector>
+#include <memory>
+
+// Bin-wise comparison of a histogram with its golden reference
+enum class ECompareMode { kNone, kRatio, kDiff, kPull };
+
+ECompareMode ParseCompareMode( const std::string& mode );
+const char* CompareModeName( ECompareMode mode );
+
+class GoldenCompare {
+  // Caches the bin arrays of the golden histogram and the comparison result
+  // for one plot. The result is recomputed only when the current histogram
+  // changes (different entries, sum of weights or binning).
+public:
+  TH1* Compare( const TH1* cur, const TH1* ref, ECompareMode mode );
+  void Clear();
+
+private:
+  static void GetBinArrays( const TH1* h, std::vector<double>& val,
+                            std::vector<double>& err2 );
+
+  const TH1*          fRefHist{nullptr};  // Golden histogram of cached arrays
+  std::vector<double> fRef, fRefErr2;     // Golden contents & squared errors
+  double              fRefIntegral{0};
+  std::vector<double> fCur, fCurErr2;     // Current contents & squared errors
+  double              fCurEntries{-1};
+  double              fCurSumw{0};
+  ECompareMode        fMode{ECompareMode::kNone};
+  std::unique_ptr<TH1> fResult;           // Comparison map (owned)
+};
+
+#endif //panguinCompare_h
@@ -0,0 +1,29 @@
+#ifndef panguinDecimate_h
+#define panguinDecimate_h
+
+#include <cstddef>
+#include <vector>
+
+// Display-side point reduction for dense graphs. These functions return the
+// indices of the points to keep, in increasing order.
+
+// Ordered series (e.g. vs. event number): keep the minimum and maximum of
+// each of 'nbuckets' groups of consecutive points.
+std::vector<size_t> DecimateMinMax( const double* y, size_t n, size_t nbuckets );
+
+// Ordered series: Largest-Triangle-Three-Buckets. Keeps 'nout' points
+// (including the first and last) that best preserve the shape of the curve.
+// 'x' must be non-decreasing.
+std::vector<size_t> DecimateLTTB( const double* x, const double* y, size_t n,
+                                  size_t nout );
+
+// Unordered scatter: keep the first point falling into each cell of an
+// nx by ny grid spanning [xmin,xmax] x [ymin,ymax]. With cells the size of a
+// screen pixel, the decimated plot is indistinguishable from the full one.
+// Points outside the grid are dropped.
+std::vector<size_t> DecimatePixelGrid( const double* x, const double* y,
+                                       size_t n, double xmin, double xmax,
+                                       double ymin, double ymax,
+                                       size_t nx, size_t ny );
+
+#endif //panguinDecimate_h
@@ -0,0 +1,76 @@
+#ifndef panguinFormula_h
+#define panguinFormula_h
+
+#include <TTree.h>
+#include <TTreeFormula.h>
+#include <TH1.h>
+#include <TString.h>
+#include <map>
+#include <tuple>
+#include <vector>
+#include <memory>
+#include <functional>
+
+std::vector<TString> SplitVarexp( const TString& varexp );
+TH1* BookTreeHist( const char* name, TTree* tree, const TString& varexp,
+                   const TString& cut );
+
+class TreeFormula : public TTreeFormula {
+  // TTreeFormula that reports missing branches after UpdateFormulaLeaves()
+public:
+  using TTreeFormula::TTreeFormula;
+  bool IsMissingLeaf() const { return TestBit(kMissingLeaf); }
+};
+
+class TreeExpr {
+  // Compiled tree draw expression: up to three variables ("z:y:x") and a
+  // cut, which as in TTree::Draw acts as a weight. Evaluates the same
+  // entries as TTree::Draw would, but without parsing the expressions and
+  // setting up a selector every time.
+public:
+  TreeExpr( TTree* tree, const TString& varexp, const TString& cut );
+  TreeExpr( const TreeExpr& ) = delete;
+  TreeExpr& operator=( const TreeExpr& ) = delete;
+
+  // Called with the values of the variables, in the order of 'varexp',
+  // and the weight of each selected entry (or array element)
+  using Callback_t = std::function<void( const Double_t* v, Double_t w )>;
+
+  bool     IsValid() const { return fValid; }
+  Int_t    GetDimension() const { return static_cast<Int_t>(fVar.size()); }
+  TTree*   GetTree() const { return fTree; }
+  bool     Rebind( TTree* tree );
+  Long64_t Eval( Long64_t first, Long64_t n, const Callback_t& fcn );
+  Long64_t Fill( TH1* hist, Long64_t first, Long64_t n );
+
+private:
+  TTree*  fTree;
+  Int_t   fTreeNumber{-1};  // Current tree of a TChain
+  bool    fValid{false};
+  std::vector<std::unique_ptr<TreeFormula>> fVar;
+  std::unique_ptr<TreeFormula> fCut;
+};
+
+class FormulaCache {
+  // Compiled tree draw expressions, kept across monitor updates. Keyed by
+  // tree name, variable expression and cut. The expressions point into the
+  // branches of the trees they were compiled for, so NewFile() must be
+  // called whenever the input file is reopened. Each expression is then
+  // rebound to the tree of the new file when it is next used, instead of
+  // being compiled again. The rebinding does not depend on the address of
+  // the tree, which the new tree may share with the old one.
+public:
+  TreeExpr* Get( TTree* tree, const TString& varexp, const TString& cut );
+  void NewFile() { ++fGeneration; }
+
+private:
+  struct Entry {
+    std::unique_ptr<TreeExpr> expr;
+    UInt_t generation{0};  // Input file the expression is bound to
+  };
+  using Key_t = std::tuple<std::string, std::string, std::string>;
+  UInt_t fGeneration{0};  // Incremented for each input file opened
+  std::map<Key_t, Entry> fExpr;
+};
+
+#endif //panguinFormula_h
@@ -0,0 +1,55 @@
+#ifndef panguinHistory_h
+#define panguinHistory_h
+
+#include <TH1.h>
+#include <ctime>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+
+class HistHistory {
+  // Bounded history of histogram snapshots, one track per plot. Only the
+  // newest snapshot of each track is stored in full. Older snapshots are
+  // stored as sparse deltas relative to the next newer one, so slowly
+  // changing histograms cost little memory. When the total size exceeds the
+  // budget, the globally oldest snapshots are discarded.
+public:
+  explicit HistHistory( size_t budget = 0 ) : fBudget{budget} {}
+
+  void   Record( const std::string& key, const TH1* h, time_t t );
+  time_t GetContents( const std::string& key, time_t when,
+                      std::vector<double>& contents, double& entries ) const;
+  time_t GetOlder( time_t when ) const;
+  time_t GetNewer( time_t when ) const;
+  void   SetBudget( size_t budget ) { fBudget = budget; Shrink(); }
+  size_t GetBudget() const { return fBudget; }
+  size_t GetUsage() const { return fUsage; }
+  void   Clear();
+
+private:
+  struct Delta {
+    time_t                time{0};
+    double                entries{0};
+    std::vector<uint32_t> index;  // Bins that differ from the next newer
+    std::vector<double>   diff;   // Content of this minus next newer
+  };
+  struct Track {
+    std::string         binning;  // Binning signature
+    std::vector<double> latest;   // Full contents of newest snapshot
+    time_t              time{0};
+    double              entries{0};
+    std::deque<Delta>   older;    // Oldest first
+    size_t              bytes{0};
+  };
+
+  static std::string BinningSignature( const TH1* h );
+  void Shrink();
+
+  std::map<std::string, Track> fTracks;
+  size_t fBudget;     // Maximum memory use in bytes (0 = unlimited)
+  size_t fUsage{0};   // Current memory use in bytes (approximate)
+};
+
+#endif //panguinHistory_h
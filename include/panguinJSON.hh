@@ -0,0 +1,39 @@
+#ifndef panguinJSON_h
+#define panguinJSON_h
+
+#include <TCanvas.h>
+#include <TString.h>
+#include <vector>
+#include <string>
+
+class JsonExport {
+  // Batch output in JSON format (plotFormat json). Each pad is written as a
+  // separate JSON file with TBufferJSON, without rasterizing anything. A
+  // manifest lists the pages and their pads, and a static index.html
+  // renders them in a web browser with JSROOT, keeping the plots
+  // interactive (zoom, tooltips etc.).
+public:
+  JsonExport( std::string dir, bool compress,
+              std::string jsroot = std::string() );
+
+  const std::string& GetDir() const { return fDir; }
+  Int_t AddPage( const TString& title, const TString& heading,
+                 TCanvas* canvas, Int_t nx, Int_t ny );
+  bool  Close( const TString& title, Int_t run, const std::string& config );
+
+private:
+  struct Page {
+    std::string title;
+    std::string heading;            // Page header, as in the image formats
+    Int_t nx, ny;
+    std::vector<std::string> pads;  // JSON file names (relative to fDir)
+  };
+  bool WriteFile( const std::string& name, const TString& contents ) const;
+
+  std::string fDir;        // Output directory
+  std::string fJsroot;     // URL of JSROOT, without trailing slash
+  Int_t fCompact;          // TBufferJSON compact level
+  std::vector<Page> fPages;
+};
+
+#endif //panguinJSON_h
@@ -0,0 +1,52 @@
+#ifndef panguinLive_h
+#define panguinLive_h
+
+#include <TFile.h>
+#include <TSocket.h>
+#include <vector>
+#include <string>
+#include <memory>
+#include <ctime>
+
+class TMapFile;
+class TMessage;
+class TCanvas;
+
+class LiveSource {
+  // Histograms published by a running analyzer, read without going through
+  // a ROOT file on disk. Two transports are supported:
+  //   mapfile:<file>        shared memory map file (TMapFile)
+  //   socket:<host>:<port>  TSocket; the string "get" is sent, and a
+  //                         TMessage with a TList of histograms is expected
+  //   server:<host>:<port>  panguin running with --serve (see PageServer);
+  //                         complete pages are fetched with FetchPage()
+  // At each update, the published objects are copied into an in-memory
+  // file, so that they can be accessed like those of a regular ROOT file.
+public:
+  explicit LiveSource( const std::string& spec );
+  ~LiveSource();
+
+  bool   IsValid() const { return fType != kNone; }
+  bool   IsPageServer() const { return fType == kServer; }
+  void   SetSelection( const std::vector<std::string>& names );
+  TFile* Open();
+  TCanvas* FetchPage( Int_t page, Int_t& run );
+  time_t GetUpdateTime() const { return fUpdateTime; }
+
+private:
+  enum EType { kNone, kMapFile, kSocket, kServer };
+  bool ReadMapFile( TDirectory* dir );
+  bool ReadSocket( TDirectory* dir );
+  std::unique_ptr<TMessage> Request( const char* request );
+
+  EType       fType{kNone};
+  std::string fName;                    // Map file name or host name
+  Int_t       fPort{0};                 // Port number (socket)
+  std::vector<std::string> fSelection;  // Objects to read from map file
+  TMapFile*   fMapFile{nullptr};        // Open map file (owned)
+  std::unique_ptr<TSocket> fSocket;     // Connection to publisher
+  time_t      fUpdateTime{0};           // Time of last successful read
+                                        // (server: time of its input)
+};
+
+#endif //panguinLive_h
@@ -0,0 +1,44 @@
+#ifndef panguinNtuple_h
+#define panguinNtuple_h
+
+#include <TDirectory.h>
+#include <TCut.h>
+#include <TH1.h>
+#include <TString.h>
+#include <vector>
+#include <string>
+#include <memory>
+
+class NtupleSource {
+  // RNTuples in the input file(s) and an index of their fields, so that
+  // tree-style draw commands can be filled from RNTuples as well. Filling
+  // is done with RDataFrame. Requires ROOT 6.34 or later; with older
+  // versions, RNTuples are reported but cannot be drawn.
+public:
+  static bool IsNtupleClass( const TString& classname );
+  static bool IsSupported();
+
+  void  Scan( const std::vector<std::string>& files );
+  Int_t FindIndex( const TString& var, const std::string& name ) const;
+  const std::string& GetName( Int_t i ) const { return fNtuples[i].name; }
+  const std::vector<std::string>& GetFields( Int_t i ) const
+  { return fNtuples[i].fields; }
+  size_t GetSize() const { return fNtuples.size(); }
+  std::unique_ptr<TH1> Draw( Int_t i, const TString& varexp, const TCut& cut,
+                             Long64_t& nsel ) const;
+  void Clear();
+
+private:
+  struct Ntuple {
+    std::string name;                 // Path in file
+    std::vector<std::string> fields;  // Qualified names of all fields
+  };
+  void ScanDirectory( TDirectory* dir, const std::string& path,
+                      const std::string& file );
+
+  std::vector<std::string> fFiles;    // Files containing the RNTuples
+  std::vector<std::string> fScanned;  // Files of the last scan
+  std::vector<Ntuple>      fNtuples;
+};
+
+#endif //panguinNtuple_h
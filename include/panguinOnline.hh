@@ -10,11 +10,15 @@
 #include <TGFrame.h>
 #include <TGListBox.h>
 #include <TRootEmbeddedCanvas.h>
+#include <TGNumberEntry.h>
 #include "TGLabel.h"
 #include "TGString.h"
 #include <vector>
 #include <string>
 #include <map>
+#include <set>
+#include <memory>
+#include <ctime>
 #include <TString.h>
 #include <TCut.h>
 #include <TTimer.h>
@@ -22,6 +26,26 @@
 #include "TH2.h"
 #include "TH3.h"
 #include "panguinOnlineConfig.hh"
+#include "panguinCompare.hh"
+#include "panguinHistory.hh"
+#include "panguinStripChart.hh"
+#include "panguinRebin.hh"
+#include "panguinSegments.hh"
+#include "panguinTrend.hh"
+#include "panguinOverlay.hh"
+#include "panguinNtuple.hh"
+#include "panguinLive.hh"
+#include "panguinServer.hh"
+#include "panguinProgressive.hh"
+#include "panguinBudget.hh"
+#include "panguinBinning.hh"
+#include "panguinPadCache.hh"
+#include "panguinSchedule.hh"
+#include "panguinFormula.hh"
+#include "panguinShared.hh"
+#include "panguinStyle.hh"
+#include "panguinPlugins.hh"
+#include "panguinPreload.hh"
 
 #define UPDATETIME 10000
 
@@ -43,11 +67,17 @@ class OnlineGUI {
   TGTextButton* fExit = nullptr;
   TGLabel* fRunNumber = nullptr;
   TGTextButton* fPrint = nullptr;
+  TGTextButton* fHistOlder = nullptr; // history: previous snapshot
+  TGTextButton* fHistNewer = nullptr; // history: next snapshot
+  TGTextButton* fHistLive = nullptr;  // history: back to live view
+  TGNumberEntry* fHistWindow = nullptr; // history: show last N minutes only
+  TGLabel* fHistLabel = nullptr;
   TCanvas* fCanvas = nullptr; // Present Embedded canvas
   TFile* fRootFile = nullptr;
   TFile* fGoldenFile = nullptr;
   TTimer* timer = nullptr;
   TTimer* timerNow = nullptr; // used to update time
+  TTimer* fProgressTimer = nullptr; // refines sampled tree plots
   TH1* mytemp1d = nullptr;
   TH2* mytemp2d = nullptr;
   TH3* mytemp3d = nullptr;
@@ -63,6 +93,13 @@ class OnlineGUI {
   Bool_t fFileAlive;
   Bool_t fPrintOnly;
   Bool_t fSaveImages;
+  Bool_t fTakeSnapshot;     // Record history snapshots in next DoDraw
+  time_t fHistoryTime;      // Time of displayed snapshot (0 = live)
+  Int_t fHistoryWindow;     // Show changes in last N minutes only (0 = all)
+  HistHistory fHistory;     // Snapshots of monitored plots
+  std::map<std::string, std::unique_ptr<TH1>> fHistoryHists; // Displayed past states
+  TrendStore fTrend;        // Run-over-run summaries of plots
+  RunOverlayCache fOverlays; // Histograms of earlier runs for overlays
 
   struct RootFileObj {
     TString name;   // Full path to object (dir/objname)
@@ -73,10 +110,54 @@ class OnlineGUI {
   std::vector<Int_t> fTreeEntries;
   std::vector<RootFileObj> fileObjects;
   std::vector<std::vector<TString> > treeVars;
+  NtupleSource fNtuples;   // RNTuples in the input file(s)
+  std::map<std::string, GoldenCompare> fGoldenCompare; // Cached golden comparisons
+  std::map<std::string, StripChart> fStripCharts;      // Strip chart windows
+  std::map<std::string, DisplayRebin> fDisplayRebin;  // Display copies of large 2D histograms
+  std::unique_ptr<SegmentedRun> fSegments;  // Segments of a multi-file run
+  std::unique_ptr<LiveSource> fLive;  // Histograms published by the analyzer,
+                                      // or pages drawn by a panguin server
+  std::map<Int_t, std::unique_ptr<TCanvas>> fServedPages;  // Last pages received
+  std::set<Int_t> fDensePads;  // Pads of current page to rasterize in vector output
+  struct ProgressiveJob {
+    std::unique_ptr<ProgressiveFill> fill;
+    std::string key;        // Pad of the plot ("page/pad")
+    bool snapshot{false};   // Record in history when complete
+    bool cache{false};      // Save in pad cache when complete
+  };
+  std::vector<ProgressiveJob> fProgressive; // Sampled plots being refined
+  size_t fNextProgressive{0};  // Job to refine in the next ProgressiveStep()
+  std::unique_ptr<DrawBudget> fBudget;  // Pad and page time budgets
+  PadCache fPadCache;          // Last contents of pads, for pads not redrawn
+  RefreshSchedule fSchedule;   // Deadlines of pads with "-every"/"-refresh"
+  FormulaCache fFormulas;      // Compiled tree expressions for incremental fills
+  std::map<Int_t, std::unique_ptr<TH1>> fPrefilled; // Pad -> histogram filled by SharedTreeFill
+  std::unique_ptr<BinningResolver> fBinning;  // Frozen binning of tree draws
+  struct FrozenHist {
+    std::string key;            // Plot filled into 'hist'
+    std::string input;          // Run and file the entries were read from
+    std::unique_ptr<TH1> hist;  // Histogram with frozen binning
+    Long64_t next{0};           // First tree entry not yet filled
+  };
+  std::map<std::string, FrozenHist> fFrozenHists;  // Pad -> incremental histogram
+  std::map<UInt_t, PageStyle> fPageStyles;  // Page -> histogram style
+  const PageStyle* fStyle{nullptr};         // Style of the current page
+  LibraryRegistry fLibraries;  // Libraries of loadlib/loadmacro commands
+  std::unique_ptr<ParallelReader> fPreloader;  // Parallel reads of fRootFile
 
   std::string SubstitutePlaceholders(
     std::string str, const std::string& var = std::string() ) const;
   void DeleteGUI();
+  void PadHistory( time_t now, bool record );
+  void UpdateHistoryLabel();
+  void RasterizeDensePads();
+  void NotePad( const std::string& text, Color_t color ) const;
+  void PreloadHistograms();
+  void PrefillTreePads();
+  TFile* OpenInputFile();
+  void   CloseInputFile();
+  Bool_t ReopenInput();
+  time_t GetRootFileTime() const;
 
 public:
   using cmdmap_t = std::map<std::string, std::string>;
@@ -85,6 +166,7 @@ public:
   void CreateGUI( const TGWindow* p, UInt_t w, UInt_t h );
   virtual ~OnlineGUI();
   void DoDraw();
+  void DrawPads();
   void DrawPrev();
   void DrawNext();
   void DoListBox( Int_t id );
@@ -93,14 +175,27 @@ public:
   Bool_t IsHistogram( const TString& objectname ) const;
   static Bool_t IsHistogram( const RootFileObj& fileObject );
   Bool_t IsPrintOnly() const { return fPrintOnly; }
+  Bool_t IsServer() const { return fConfig.GetServePort() > 0; }
   void GetFileObjects();
   void ScanFileObjects( TIter& iter, const TString& directory );
   void GetTreeVars();
   void GetRootTree();
   UInt_t GetTreeIndex( const TString& );
   UInt_t GetTreeIndexFromName( const TString& );
+  UInt_t FindTreeIndex( const cmdmap_t& command, const TString& var );
+  TCut MakeCut( const cmdmap_t& command );
   void TreeDraw( const cmdmap_t& command );
+  std::unique_ptr<TH1> FrozenDraw( const cmdmap_t& command, UInt_t iTree,
+                                   const TString& var, const TCut& cut,
+                                   const TString& drawopt, Long64_t& nentries );
+  void NtupleDraw( const cmdmap_t& command, Int_t iNtuple );
+  void StripChartDraw( const cmdmap_t& command );
+  void DecimatePad( const cmdmap_t& command );
+  void TrendRecord( const cmdmap_t& command );
+  void TrendDraw( const cmdmap_t& command );
   void HistDraw( const cmdmap_t& command );
+  Bool_t GoldenCompareDraw( TH1* hist, const cmdmap_t& command );
+  void OverlayDraw( TH1* hist, const cmdmap_t& command );
   void MacroDraw( const cmdmap_t& command );
   void LoadDraw( const cmdmap_t& command );
   void LoadLib( const cmdmap_t& command );
@@ -109,12 +204,19 @@ public:
   void DoDrawClear();
   void TimerUpdate();
   void UpdateCurrentTime();  // update current time
+  void ProgressiveStep();
+  void HistoryOlder();
+  void HistoryNewer();
+  void HistoryLive();
+  void HistoryWindow( Long_t );
   static void BadDraw( const TString& );
   void CheckRootFile();
   Int_t OpenRootFile();
   Int_t PrepareRootFiles();
   void PrintToFile();
   void PrintPages();
+  void Serve();
+  void ServedPageDraw();
   void MyCloseWindow();
   void CloseGUI();
   void SetVerbosity( int ver ) { fVerbosity = ver; }
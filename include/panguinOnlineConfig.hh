@@ -20,6 +20,7 @@ using PageInfo_t = std::vector<std::pair<uint_t, uint_t>>;
 std::string ReplaceAll(
   std::string str, const std::string& ostr, const std::string& nstr );
 bool EndsWith( const std::string& str, const std::string& tail );
+long long ParseInterval( const std::string& str );
 
 class OnlineConfig {
   // Class that takes care of the config file
@@ -38,9 +39,15 @@ class OnlineConfig {
   std::string fImageFormat;       // File format for saved image files (default: png)
   std::string fImagesDir;         // Where to save individual images
   std::string plotsdir;           // Where to save plots
+  std::string fTrendFile;         // Store of run-over-run plot summaries
+  std::string fLiveSource;        // Shared memory or socket histogram source
+  std::string fArchiveFile;       // ROOT file for all drawn objects (batch)
+  std::string fJsrootUrl;         // JSROOT location for the JSON viewer
+  std::string fBinningFile;       // Cache of frozen tree draw binning
   // the config file, in memory
   ConfLines_t sConfFile;
   VecStr_t    fProtoRootFiles; // Candidate ROOT file names
+  VecStr_t    fMergeFiles;     // Files or patterns of files to merge
   // pageInfo is the vector of the pages containing the sConfFile index
   //   and how many commands issued within that page (title, 1d, etc.)
   PageInfo_t  pageInfo;
@@ -56,10 +63,23 @@ class OnlineConfig {
   int fPadNoWidth;
   bool fPrintOnly;
   bool fSaveImages;
+  int fHistoryBudget;             // Memory for monitor history (MB)
+  int fUpdateTime;                // Monitor update interval (ms, 0 = default)
+  int fServePort;                 // Port for serving pages (0 = GUI/batch)
+  bool fJsonCompress;             // Compress arrays in JSON output
+  int fArchiveCompression;        // Compression setting of archive (-1 = default)
+  int fProgressiveEntries;        // Sample trees with at least this many entries (0 = never)
+  double fSampleFraction;         // Fraction of entries to sample
+  int fPadBudget;                 // Time budget for drawing a pad (ms, 0 = none)
+  int fPageBudget;                // Time budget for drawing a page (ms, 0 = none)
+  bool fFixBinning;               // Freeze the binning of tree draw histograms
+  int fThreads;                   // Worker threads (0 = not set)
+  bool fMergeAll;                 // Merge all histograms of merged files
 
   int LoadFile( std::ifstream& infile, const std::string& filename );
   int CheckLoadIncludeFile( const std::string& sline,
                             const VecStr_t& strvect );
+  std::string LocateRootFile( int runnumber, bool verbose ) const;
 
   struct CommandDef {
     CommandDef( std::string cmd, size_t nargs,
@@ -82,7 +102,9 @@ public:
     CmdLineOpts( std::string f, std::string d, std::string rf,
                  std::string gf, std::string rd, std::string pf,
                  std::string ifm, std::string pd, std::string id,
-                 int rn, int v, bool po, bool si )
+                 int rn, int v, bool po, bool si,
+                 VecStr_t mf = VecStr_t(), std::string lv = std::string(),
+                 int sp = 0, int nt = 0 )
       : cfgfile(std::move(f))
       , cfgdir(std::move(d))
       , rootfile(std::move(rf))
@@ -96,6 +118,10 @@ public:
       , verbosity(v)
       , printonly(po)
       , saveimages(si)
+      , mergefiles(std::move(mf))
+      , livesource(std::move(lv))
+      , serveport(sp)
+      , threads(nt)
     {}
     std::string cfgfile;
     std::string cfgdir;
@@ -110,6 +136,10 @@ public:
     int verbosity{0};
     bool printonly{false};
     bool saveimages{false};
+    VecStr_t mergefiles;
+    std::string livesource;
+    int serveport{0};
+    int threads{0};
   };
 
   OnlineConfig();
@@ -129,6 +159,10 @@ public:
   }
   void SetVerbosity( int ver ) { fVerbosity = ver; }
   const char* GetRootFile() const { return rootfilename.c_str(); };
+  bool IsMultiFile() const;
+  VecStr_t GetRootFiles() const;
+  VecStr_t GetReferencedObjects();
+  VecStr_t GetMergeSelection();
   const char* GetGoldenFile() const { return goldenrootfilename.c_str(); };
   const std::string& GetGuiColor() const { return guicolor; };
   const std::string& GetProtoPlotFile() const { return fProtoPlotFile; }
@@ -139,12 +173,30 @@ public:
   const std::string& GetImageFormat() const { return fImageFormat; }
   const std::string& GetPlotsDir() const { return plotsdir; };
   const std::string& GetImagesDir() const { return fImagesDir; };
+  const std::string& GetTrendFile() const { return fTrendFile; }
   int GetVerbosity() const { return fVerbosity; }
   int GetRunNoWidth() const { return fRunNoWidth; }
   int GetPageNoWidth() const { return fPageNoWidth; }
   int GetPadNoWidth() const { return fPadNoWidth; }
   bool DoPrintOnly() const { return fPrintOnly; }
   bool DoSaveImages() const { return fSaveImages; }
+  int GetHistoryBudget() const { return fHistoryBudget; }
+  int GetUpdateTime() const { return fUpdateTime; }
+  const std::string& GetLiveSource() const { return fLiveSource; }
+  bool IsLive() const { return !fLiveSource.empty(); }
+  bool IsPageClient() const { return fLiveSource.compare(0, 7, "server:") == 0; }
+  int GetServePort() const { return fServePort; }
+  bool DoJsonCompress() const { return fJsonCompress; }
+  const std::string& GetJsrootUrl() const { return fJsrootUrl; }
+  const std::string& GetArchiveFile() const { return fArchiveFile; }
+  int GetArchiveCompression() const { return fArchiveCompression; }
+  int GetProgressiveEntries() const { return fProgressiveEntries; }
+  double GetSampleFraction() const { return fSampleFraction; }
+  int GetPadBudget() const { return fPadBudget; }
+  int GetPageBudget() const { return fPageBudget; }
+  bool DoFixBinning() const { return fFixBinning; }
+  const std::string& GetBinningFile() const { return fBinningFile; }
+  int GetThreads() const { return fThreads; }
   const std::string& GetDefinedCut( const std::string& ident );
   VecStr_t GetCutIdent();
   // Page utilites
@@ -155,6 +207,7 @@ public:
   uint_t GetDrawCount( uint_t );           // Number of histograms in a page
   void GetDrawCommand( uint_t, uint_t, std::map<std::string, std::string>& );
   void OverrideRootFile( int runnumber );
+  VecStr_t FindRunFiles( int runnumber ) const;
   bool IsMonitor() const { return fMonitor; };
 };
 
@@ -0,0 +1,42 @@
+#ifndef panguinOverlay_h
+#define panguinOverlay_h
+
+#include <TH1.h>
+#include <vector>
+#include <string>
+#include <map>
+#include <list>
+#include <memory>
+#include <utility>
+#include <functional>
+
+class RunOverlayCache {
+  // Histograms of earlier runs for overlays on the current run's plots.
+  // Each histogram is read from its run's file(s) once and kept in a
+  // least-recently-used cache of at most 'capacity' histograms, so that
+  // repeated updates only need to refresh the current run.
+public:
+  using Finder_t = std::function<std::vector<std::string>(Int_t)>;
+
+  explicit RunOverlayCache( size_t capacity = 64, Finder_t finder = nullptr );
+
+  std::vector<Int_t> FindPrevious( Int_t run, size_t n );
+  TH1*   Get( Int_t run, const std::string& name );
+  size_t GetSize() const { return fItems.size(); }
+  void   Clear();
+
+private:
+  using Key_t  = std::pair<Int_t, std::string>;
+  using Item_t = std::pair<Key_t, std::unique_ptr<TH1>>;
+  const std::vector<std::string>& GetRunFiles( Int_t run );
+  static TH1* Load( const std::vector<std::string>& files,
+                    const std::string& name );
+
+  size_t   fCapacity;
+  Finder_t fFinder;                      // Returns the file(s) of a run
+  std::list<Item_t> fItems;              // Most recently used first
+  std::map<Key_t, std::list<Item_t>::iterator> fIndex;
+  std::map<Int_t, std::vector<std::string>> fRunFiles;  // Found files by run
+};
+
+#endif //panguinOverlay_h
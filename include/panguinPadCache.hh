@@ -0,0 +1,37 @@
+#ifndef panguinPadCache_h
+#define panguinPadCache_h
+
+#include <TVirtualPad.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <memory>
+#include <ctime>
+
+class PadCache {
+  // Copies of the contents of pads, for redrawing a pad without
+  // recomputing it. Axis frames and titles, which ROOT recreates when
+  // drawing, are not copied, nor are objects named "panguin_note" (status
+  // notes that are added anew after each draw).
+public:
+  void Save( const std::string& key, TVirtualPad* pad );
+  bool Restore( const std::string& key, TVirtualPad* pad ) const;
+  bool Has( const std::string& key ) const { return fPads.count(key) > 0; }
+  time_t GetTime( const std::string& key ) const;
+  void Clear() { fPads.clear(); }
+
+private:
+  struct Item {
+    std::unique_ptr<TObject> obj;
+    std::string option;
+  };
+  struct Contents {
+    std::vector<Item> items;
+    Int_t logx, logy, logz, gridx, gridy;
+    Double_t margin[4];  // left, right, bottom, top
+    time_t time;         // When saved
+  };
+  std::map<std::string, Contents> fPads;
+};
+
+#endif //panguinPadCache_h
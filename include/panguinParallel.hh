@@ -0,0 +1,36 @@
+#ifndef panguinParallel_h
+#define panguinParallel_h
+
+#include <TTree.h>
+#include <TH1.h>
+#include <TString.h>
+#include "panguinFormula.hh"
+#include <string>
+
+class ParallelTreeFill {
+  // Fill a histogram with fixed binning from a range of tree entries on
+  // several threads. The entries are split into parts of a fixed size.
+  // Each part is filled into its own copy of the histogram by a worker
+  // reading the tree through its own file handle, and the parts are added
+  // up in entry order. The split does not depend on the number of threads,
+  // so the result is the same with any number of threads, including one.
+public:
+  ParallelTreeFill( TTree* tree, const TString& varexp, const TString& cut,
+                    unsigned nthreads, FormulaCache* formulas = nullptr );
+
+  Long64_t Fill( TH1* hist, Long64_t first, Long64_t n );
+
+private:
+  Long64_t FillPart( TTree* tree, TH1* hist, Long64_t first, Long64_t n,
+                     FormulaCache* formulas ) const;
+
+  TTree*        fTree;
+  TString       fVarexp;
+  TString       fCut;
+  unsigned      fNthreads;
+  FormulaCache* fFormulas;
+  std::string   fFile;      // File to open in workers, empty if not possible
+  std::string   fTreePath;  // Path of the tree in fFile
+};
+
+#endif //panguinParallel_h
@@ -0,0 +1,53 @@
+#ifndef panguinPlugins_h
+#define panguinPlugins_h
+
+#include <TString.h>
+#include <string>
+#include <map>
+
+class TVirtualPad;
+class TFile;
+
+// Draw function of a compiled plugin. Draws into 'pad' from 'file', the
+// current ROOT file, with the arguments 'args' given in the configuration.
+typedef void (*PanguinDraw_t)( TVirtualPad* pad, TFile* file, const char* args );
+
+// Define draw function 'name' of a plugin library. A "loadmacro" command
+// calling name(args) runs it directly, e.g. in the plugin
+//
+//   PANGUIN_DRAW(adcsum) { ... }
+//
+// and in the configuration
+//
+//   loadmacro libMyPlots.so adcsum(3,"left")
+#define PANGUIN_DRAW(name)                                               \
+  extern "C" void panguin_draw_##name( TVirtualPad* pad, TFile* file,   \
+                                       const char* args )
+
+class LibraryRegistry {
+  // Shared libraries of "loadlib" and "loadmacro" commands. Each library is
+  // loaded once, and the outcome is kept, so that redrawing a page neither
+  // loads a library again nor retries one that failed. Plugin draw
+  // functions are looked up once per library and name.
+public:
+  bool Load( const std::string& lib );
+  PanguinDraw_t FindDraw( const std::string& lib, const std::string& name );
+
+  // Why the last Load() of 'lib' failed, empty if it did not
+  const std::string& GetError( const std::string& lib ) const;
+
+private:
+  struct Library {
+    std::string error;  // Load failure, empty if loaded
+    std::map<std::string, PanguinDraw_t> draws;  // Name -> draw function or nullptr
+  };
+  std::map<std::string, Library> fLibs;
+};
+
+// Split macro command "name(args)" into the function name and the
+// arguments without the parentheses. Returns false if 'call' does not
+// have this form.
+bool SplitMacroCall( const std::string& call, std::string& name,
+                     std::string& args );
+
+#endif //panguinPlugins_h
@@ -0,0 +1,40 @@
+#ifndef panguinPreload_h
+#define panguinPreload_h
+
+#include <TObject.h>
+#include <TFile.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include <utility>
+
+class ParallelReader {
+  // Read objects from ROOT file 'file' on up to 'nthreads' worker threads,
+  // each with its own handle of the file, so that decompression runs in
+  // parallel. The handles are opened on first use and kept for later
+  // reads, which see the keys added to the file since. A new reader is
+  // needed only when the file is replaced (see IsFile()).
+public:
+  ParallelReader( std::string file, unsigned nthreads );
+  ~ParallelReader();
+
+  // Read the objects with paths 'names' ("dir/name"). Returns them in the
+  // order of 'names', nullptr for those not found. The objects are not
+  // attached to any directory.
+  std::vector<std::unique_ptr<TObject>>
+  Read( const std::vector<std::string>& names );
+
+  const std::string& GetFile() const { return fFile; }
+  unsigned GetNthreads() const { return fNthreads; }
+  bool IsFile( const std::string& file ) const;
+
+private:
+  static std::pair<Long_t, Long_t> GetFileId( const std::string& file );
+
+  std::string fFile;
+  std::pair<Long_t, Long_t> fFileId;  // Device and inode of fFile
+  unsigned    fNthreads;
+  std::vector<std::unique_ptr<TFile>> fHandles;  // One per worker
+};
+
+#endif //panguinPreload_h
@@ -0,0 +1,51 @@
+#ifndef panguinProgressive_h
+#define panguinProgressive_h
+
+#include <TTree.h>
+#include <TCut.h>
+#include <TH1.h>
+#include <TVirtualPad.h>
+#include <TString.h>
+#include "panguinFormula.hh"
+#include <vector>
+#include <utility>
+
+class ProgressiveFill {
+  // Fill a tree-draw histogram in stages. DrawSample() fills it from a
+  // sample of the entries, taken as a few contiguous blocks spread over the
+  // whole tree, which is much cheaper to read than a strided or random
+  // selection of single entries. Step() then adds the remaining entries in
+  // chunks of limited duration, so that the GUI stays responsive while the
+  // histogram converges to the full statistics.
+public:
+  ProgressiveFill( TTree* tree, TString varexp, TCut cut, Double_t fraction,
+                   FormulaCache* formulas = nullptr );
+
+  Long64_t DrawSample( const TString& hname, const TString& drawopt,
+                       Double_t maxtime = 0 );
+  bool     Step( Double_t seconds );
+  bool     IsDone() const { return fPending.empty(); }
+  Double_t GetFraction() const;
+  TH1*     GetHist() const { return fHist; }
+  TVirtualPad* GetPad() const { return fPad; }
+  void     UpdateTitle();
+
+private:
+  typedef std::pair<Long64_t, Long64_t> Range_t;  // first entry, count
+  Long64_t Fill( const Range_t& range, const char* option );
+
+  TTree*       fTree;
+  TString      fVarexp;
+  TCut         fCut;
+  Double_t     fFraction;   // Requested sample fraction
+  FormulaCache* fFormulas;  // Compiled expressions, if any
+  TH1*         fHist{nullptr};
+  TVirtualPad* fPad{nullptr};
+  TString      fSuffix;     // Progress indicator appended to title
+  Long64_t     fTotal{0};   // Entries in tree
+  Long64_t     fDone{0};    // Entries processed so far
+  Double_t     fRate{0};    // Entries per second
+  std::vector<Range_t> fPending;  // Entry ranges still to process
+};
+
+#endif //panguinProgressive_h
@@ -0,0 +1,40 @@
+#ifndef panguinRebin_h
+#define panguinRebin_h
+
+#include <TH2.h>
+#include <TString.h>
+#include <vector>
+#include <memory>
+
+class DisplayRebin {
+  // Display copy of a 2D histogram with about as many bins as the pad has
+  // pixels. The copy is rebuilt only when the source histogram changes, the
+  // pad is resized, or the user zooms the copy. The zoomed range is then
+  // re-derived from the source at the finest resolution the pad can show,
+  // while the bins outside of it remain coarse. The source is identified by
+  // name and binning, not by address, so that the copy and its zoom survive
+  // the input file being reopened on a monitor update.
+public:
+  TH2* Get( TH2* src, Int_t npx, Int_t npy );
+  void Clear();
+
+private:
+  static void MakeGroups( const TAxis* ax, Int_t first, Int_t last,
+                          Int_t npix, std::vector<Int_t>& map,
+                          std::vector<Double_t>& edges );
+  void Build( const TH2* src, Int_t npx, Int_t npy );
+  static std::vector<Double_t> GetBinning( const TH2* src );
+  bool IsSource( const TH2* src ) const;
+  bool IsUnchanged( const TH2* src ) const;
+
+  TString     fSource;             // Name of the histogram the copy is of
+  Double_t    fEntries{-1};        // Entries of source at time of build
+  std::vector<Double_t> fBinning;  // Bins and axis ranges of source
+  std::vector<Double_t> fStats;    // Statistics of source at time of build
+  Int_t       fNpx{0}, fNpy{0};    // Pad size in pixels at build
+  Double_t    fXlo{0}, fXhi{0};    // Displayed x-range at build
+  Double_t    fYlo{0}, fYhi{0};    // Displayed y-range at build
+  std::unique_ptr<TH2> fDisplay;   // Display copy (owned)
+};
+
+#endif //panguinRebin_h
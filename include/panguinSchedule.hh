@@ -0,0 +1,24 @@
+#ifndef panguinSchedule_h
+#define panguinSchedule_h
+
+#include <map>
+#include <string>
+
+class RefreshSchedule {
+  // Redraw deadlines of pads with their own refresh cadence in monitor mode.
+  // A pad is due either every N monitor updates ("ticks") or when a given
+  // time has passed since it was last recomputed, whichever comes first.
+public:
+  bool IsDue( const std::string& key, int every, long long interval,
+              long long now, bool tick );
+  void Clear() { fPads.clear(); }
+
+private:
+  struct Deadline {
+    int ticks{0};        // Updates since last recomputed
+    long long next{0};   // Time of next recomputation (ms)
+  };
+  std::map<std::string, Deadline> fPads;
+};
+
+#endif //panguinSchedule_h
@@ -0,0 +1,52 @@
+#ifndef panguinSegments_h
+#define panguinSegments_h
+
+#include <TFile.h>
+#include <TChain.h>
+#include <TCut.h>
+#include <TH1.h>
+#include <TString.h>
+#include <vector>
+#include <string>
+#include <set>
+#include <memory>
+#include <functional>
+
+// Run 'func(i)' for i = 0 ... n-1 on up to 'nthreads' worker threads.
+// Falls back to a serial loop if ROOT was built without multithreading.
+void ParallelFor( size_t n, unsigned nthreads,
+                  const std::function<void(size_t)>& func );
+
+class SegmentedRun {
+  // Merged view of a run written as several ROOT files ("segments"), or of
+  // several runs to be summed. Histograms with the same path in the files are
+  // summed, in parallel, into an in-memory file, so that they can be accessed
+  // like those of a single file. Trees become TChains over all files.
+public:
+  explicit SegmentedRun( unsigned nthreads = 0 );
+  ~SegmentedRun();
+
+  void   SetSelection( const std::vector<std::string>& names );
+  TFile* Open( const std::vector<std::string>& files );
+  const std::vector<TTree*>& GetChains() const { return fChains; }
+  const std::vector<std::string>& GetFiles() const { return fFiles; }
+  unsigned GetNthreads() const { return fNthreads; }
+  std::unique_ptr<TH1> Draw( TTree* tree, const TString& varexp,
+                             const TCut& cut, const TString& drawopt,
+                             Long64_t& nsel ) const;
+  void Clear();
+
+private:
+  struct Segment;
+  void ReadSegment( const std::string& file, Segment& seg ) const;
+  void ReadDirectory( TDirectory* dir, const std::string& path,
+                      Segment& seg ) const;
+  static void MergeSegments( Segment& to, Segment& from );
+
+  unsigned                 fNthreads;  // Number of worker threads
+  std::vector<std::string> fFiles;     // Segment files
+  std::vector<TTree*>      fChains;    // One TChain per tree (owned)
+  std::set<std::string>    fSelection; // Histograms to read (empty: all)
+};
+
+#endif //panguinSegments_h
@@ -0,0 +1,40 @@
+#ifndef panguinServer_h
+#define panguinServer_h
+
+#include <TServerSocket.h>
+#include <TMonitor.h>
+#include <TMessage.h>
+#include <vector>
+#include <memory>
+#include <ctime>
+
+class TCanvas;
+
+class PageServer {
+  // Publishes the pages drawn by a headless panguin (--serve) to any number
+  // of thin clients (panguin -L server:<host>:<port>). Each page is
+  // serialized once per update, and the same buffer is sent to all clients
+  // requesting it.
+  // Protocol: the client sends the string "page <n>" (n = 1, 2, ...). The
+  // reply is a TMessage with a TList holding the page's TCanvas and the
+  // TParameter<Long64_t> objects "run" (run number) and "updated" (time of
+  // the input data), or a kMESS_NOTOK message if the page is not available.
+public:
+  explicit PageServer( Int_t port );
+  ~PageServer();
+
+  bool IsValid() const { return fServer && fServer->IsValid(); }
+  void SetPage( Int_t page, TCanvas* canvas, Int_t run, time_t updated );
+  void Serve( Long_t timeout );
+
+private:
+  void Reply( TSocket* sock, const char* request );
+  void Disconnect( TSocket* sock );
+
+  std::unique_ptr<TServerSocket> fServer;
+  TMonitor fMonitor;
+  std::vector<TSocket*> fClients;                 // Connected clients (owned)
+  std::vector<std::unique_ptr<TMessage>> fPages;  // Serialized pages
+};
+
+#endif //panguinServer_h
@@ -0,0 +1,48 @@
+#ifndef panguinShared_h
+#define panguinShared_h
+
+#include <TTree.h>
+#include <TH1.h>
+#include <TString.h>
+#include "panguinFormula.hh"
+#include <map>
+#include <string>
+#include <vector>
+#include <memory>
+
+class SharedTreeFill {
+  // Fill the 1D histograms of several pads drawing from the same tree in a
+  // single pass over the tree. Identical variable expressions and cuts are
+  // evaluated only once per entry, and the values fanned out to all
+  // histograms using them. Histograms are booked like TTree::Draw does,
+  // with automatic axis ranges. Only scalar expressions are supported.
+public:
+  explicit SharedTreeFill( TTree* tree );
+
+  Int_t    Add( const TString& var, const TString& cut );
+  Int_t    GetSize() const { return static_cast<Int_t>(fHists.size()); }
+  Long64_t Run();
+  std::unique_ptr<TH1> TakeHist( Int_t i, Long64_t& nsel );
+
+private:
+  struct Value {
+    std::unique_ptr<TreeFormula> formula;
+    Double_t value{0};
+    Long64_t entry{-1};  // Entry for which 'value' was evaluated
+  };
+  struct Hist {
+    std::unique_ptr<TH1> hist;
+    Int_t    var;        // Index into fValues
+    Int_t    cut;        // Index into fValues, -1 if none
+    Long64_t nsel{0};
+  };
+  Int_t    Compile( const TString& expr );
+  Double_t Eval( Int_t i, Long64_t entry );
+
+  TTree* fTree;
+  std::vector<Value> fValues;          // Distinct expressions and cuts
+  std::map<std::string, Int_t> fIndex; // Expression -> index into fValues
+  std::vector<Hist> fHists;
+};
+
+#endif //panguinShared_h
@@ -0,0 +1,44 @@
+#ifndef panguinStripChart_h
+#define panguinStripChart_h
+
+#include <TTree.h>
+#include <TCut.h>
+#include <TGraph.h>
+#include <TString.h>
+#include "panguinFormula.hh"
+#include <vector>
+#include <memory>
+
+class StripChart {
+  // Rolling window of the latest 'capacity' values of a tree expression,
+  // "y" or "y:x" (x defaults to Entry$). On each update, only the tree
+  // entries added since the previous update are read, newest first, and
+  // only until the window is full, so the cost of an update does not grow
+  // with the run length.
+public:
+  explicit StripChart( size_t capacity );
+
+  Long64_t Update( TTree* tree, const TString& expr, const TCut& cut,
+                   FormulaCache* formulas = nullptr );
+  TGraph*  GetGraph( size_t npix );
+  size_t   GetSize() const { return fSize; }
+  size_t   GetCapacity() const { return fCapacity; }
+  void     Clear();
+
+private:
+  void Append( const double* x, const double* y, size_t n );
+  Long64_t Read( TTree* tree, const TString& varexp, const TCut& cut,
+                 TreeExpr* compiled, Long64_t first, Long64_t n,
+                 std::vector<double>& x, std::vector<double>& y ) const;
+
+  size_t              fCapacity;
+  size_t              fHead{0};    // Index of oldest point
+  size_t              fSize{0};    // Number of points stored
+  std::vector<double> fX, fY;      // Ring buffers
+  Long64_t            fNextEntry{0};  // First tree entry not yet read
+  TString             fExpr;
+  TString             fCut;
+  std::unique_ptr<TGraph> fGraph;  // Decimated graph for display
+};
+
+#endif //panguinStripChart_h
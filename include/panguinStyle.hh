@@ -0,0 +1,38 @@
+#ifndef panguinStyle_h
+#define panguinStyle_h
+
+#include <TH1.h>
+
+class PageStyle {
+  // Style of the histograms on one page: statistics box, title, margins,
+  // axis divisions and label sizes (larger on crowded pages) and log scale.
+  // It is set up once per page. Use() makes it the current style, so that
+  // objects created while drawing the page get it, and Apply() gives it to
+  // each histogram drawn from a file, instead of gROOT->ForceStyle()
+  // restyling every object in memory on each draw.
+public:
+  PageStyle() = default;
+  PageStyle( bool logy, UInt_t draw_count );
+
+  void Use() const;
+  void Apply( TH1* hist ) const;
+
+private:
+  bool    fLogy{false};
+  Float_t fLabelSize{0.05};
+};
+
+class ForcedStyle {
+  // While in scope, objects read from files get the current style, as with
+  // gROOT->ForceStyle(). For user macros, which read their own histograms.
+public:
+  ForcedStyle();
+  ~ForcedStyle();
+  ForcedStyle( const ForcedStyle& ) = delete;
+  ForcedStyle& operator=( const ForcedStyle& ) = delete;
+
+private:
+  bool fWasForced;
+};
+
+#endif //panguinStyle_h
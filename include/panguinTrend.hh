@@ -0,0 +1,50 @@
+#ifndef panguinTrend_h
+#define panguinTrend_h
+
+#include <TH1.h>
+#include <TGraphErrors.h>
+#include <vector>
+#include <string>
+#include <map>
+#include <ctime>
+
+struct TrendSummary {
+  // Summary scalars of one plot of one run
+  Double_t entries{0};
+  Double_t mean{0}, meanerr{0};
+  Double_t rms{0}, rmserr{0};
+  Double_t integral{0};
+  Double_t chi2{0};               // Of the first fit function, if any
+  Int_t    ndf{0};
+  std::vector<Double_t> par, parerr;  // Fit parameters and errors
+};
+
+class TrendStore {
+  // Append-only store of per-plot summaries keyed by run number, kept as a
+  // TTree in a ROOT file. Batch runs add the summaries of all plots, so
+  // that trend plots over many runs can be made from the store alone,
+  // without reopening the ROOT files of the old runs.
+public:
+  explicit TrendStore( std::string file = std::string() );
+
+  void SetFile( const std::string& file );
+  const std::string& GetFile() const { return fFile; }
+  static TrendSummary Summarize( const TH1* hist );
+  void Add( Int_t run, const std::string& name, const TrendSummary& sum );
+  Int_t Write();
+  TGraphErrors* MakeGraph( const std::string& name,
+                           const std::string& quantity, size_t maxruns );
+  static bool GetValue( const TrendSummary& sum, const std::string& quantity,
+                        Double_t& val, Double_t& err );
+
+private:
+  using RunMap_t = std::map<Int_t, TrendSummary>;
+  void Load();
+
+  std::string fFile;                       // Store file name
+  time_t      fLoadTime{0};                // Modification time at last Load()
+  std::map<std::string, RunMap_t> fData;     // Stored summaries by name, run
+  std::map<std::string, RunMap_t> fPending;  // Added, not yet written
+};
+
+#endif //panguinTrend_h
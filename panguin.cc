@@ -18,8 +18,12 @@ int main( int argc, char** argv )
 {
   string cfgfile{"default.cfg"}, rootfile, goldenfile, scanfile;
   string plotfmt, imgfmt;
+  vector<string> mergefiles;
+  string livesource;
   string cfgdir, rootdir, pltdir, imgdir;
   int run{0};
+  int serveport{0};
+  int nthreads{0};
   int verbosity{0};
   bool printonly{false};
   bool saveImages{false};
@@ -35,11 +39,21 @@ int main( int argc, char** argv )
   cli.add_option("-R,--root-file", rootfile,
                  "ROOT file to process")
     ->type_name("<file name>");
+  cli.add_option("-M,--merge", mergefiles,
+                 "ROOT files to merge before plotting (wildcards allowed)")
+    ->type_name("<file names>");
+  cli.add_option("-L,--live", livesource,
+                 "Read histograms from analyzer: mapfile:<file> or "
+                 "socket:<host>:<port>, or pages from server:<host>:<port>")
+    ->type_name("<source>");
   cli.add_option("-G,--goldenroot-file", goldenfile,
                  "Reference ROOT file")
     ->type_name("<file name>");
-  cli.add_flag("-P,-b,--batch", printonly,
-               "No GUI. Save plots to summary file(s)");
+  auto* opt_batch = cli.add_flag("-P,-b,--batch", printonly,
+                                 "No GUI. Save plots to summary file(s)");
+  cli.add_option("--serve", serveport,
+                 "No GUI. Draw pages and serve them to clients on this port")
+    ->type_name("<port>")->excludes(opt_batch);
   cli.add_option("-E,--plot-format", plotfmt,
                  "Plot format (pdf, png, jpg ...)")
     ->type_name("<fmt>");
@@ -61,6 +75,10 @@ int main( int argc, char** argv )
   cli.add_option("-H,--images-dir", imgdir,
                  "Output directory for individual images (default: plots-dir)")
     ->type_name("<dir>");
+  cli.add_option("-j,--threads", nthreads,
+                 "Number of threads. Enables ROOT implicit multithreading; "
+                 "tree plots are filled in parallel only with fixbinning")
+    ->type_name("<N>")->check(CLI::Range(1, 1024));
   cli.add_option("-v,--verbosity", verbosity,
                  "Set verbosity level (>=0)")
     ->type_name("<level>");
@@ -96,10 +114,12 @@ int main( int argc, char** argv )
       auto gui
         = online({cfgfile, cfgdir, rootfile, goldenfile, rootdir, plotfmt,
                   imgfmt, pltdir, imgdir, run, verbosity, printonly,
-                  saveImages});
+                  saveImages, mergefiles, livesource, serveport, nthreads});
       if( gui ) {
         if( gui->IsPrintOnly() )
           gui->PrintPages();
+        else if( gui->IsServer() )
+          gui->Serve();
         else
           theApp.Run(true);
       }
@@ -125,7 +145,7 @@ int main( int argc, char** argv )
 unique_ptr<OnlineGUI> online( const OnlineConfig::CmdLineOpts& opts )
 {
 
-  if( opts.printonly ) {
+  if( opts.printonly || opts.serveport > 0 ) {
     if( !gROOT->IsBatch() ) {
       gROOT->SetBatch();
     }
@@ -0,0 +1,125 @@
+// Stand-in for an analyzer publishing histograms to panguin's live source
+// (panguin --live). Fills a few histograms with random data, like ROOT's
+// hsimple.C, and publishes them either in a shared memory map file or via
+// a socket server.
+
+#include "CLI11.hpp"
+#include <TH1F.h>
+#include <TH2F.h>
+#include <TProfile.h>
+#include <TList.h>
+#include <TMapFile.h>
+#include <TServerSocket.h>
+#include <TMonitor.h>
+#include <TMessage.h>
+#include <TRandom3.h>
+#include <TSystem.h>
+#include <iostream>
+#include <memory>
+#include <cstring>
+
+using namespace std;
+
+int main( int argc, char** argv )
+{
+  string mapfile;
+  int port{0};
+  int rate{10000};      // Events per second
+  int interval{200};    // Publishing interval (ms)
+  int size{16};         // Map file size (MB)
+
+  CLI::App cli("panguin-publisher: publish test histograms for panguin --live");
+  auto* opt_map = cli.add_option("-m,--mapfile", mapfile,
+                                 "Publish in shared memory map file")
+    ->type_name("<file name>");
+  auto* opt_port = cli.add_option("-p,--port", port,
+                                  "Publish via socket on this port")
+    ->type_name("<port>");
+  opt_map->excludes(opt_port);
+  cli.add_option("-n,--rate", rate, "Events per second")
+    ->capture_default_str()->type_name("<rate>");
+  cli.add_option("-i,--interval", interval, "Publishing interval (ms)")
+    ->capture_default_str()->type_name("<ms>");
+  cli.add_option("-s,--size", size, "Map file size (MB)")
+    ->capture_default_str()->type_name("<MB>");
+
+  CLI11_PARSE(cli, argc, argv)
+
+  if( mapfile.empty() && port <= 0 ) {
+    cerr << "Specify either --mapfile or --port" << endl;
+    return 1;
+  }
+
+  // With a map file, histograms created afterwards are placed in it
+  TMapFile* mfile = nullptr;
+  if( !mapfile.empty() ) {
+    mfile = TMapFile::Create(mapfile.c_str(), "RECREATE", size << 20,
+                             "panguin test histograms");
+    if( !mfile ) {
+      cerr << "Cannot create map file " << mapfile << endl;
+      return 1;
+    }
+  }
+  auto* hpx = new TH1F("hpx", "This is the px distribution", 100, -4, 4);
+  auto* hpxpy = new TH2F("hpxpy", "py vs px", 40, -4, 4, 40, -4, 4);
+  auto* hprof = new TProfile("hprof", "Profile of pz versus px", 100, -4, 4,
+                             0, 20);
+  TList hists;
+  hists.Add(hpx);
+  hists.Add(hpxpy);
+  hists.Add(hprof);
+
+  unique_ptr<TServerSocket> server;
+  TMonitor monitor;
+  if( port > 0 ) {
+    server.reset(new TServerSocket(port, true));
+    if( !server->IsValid() ) {
+      cerr << "Cannot listen on port " << port << endl;
+      return 1;
+    }
+    monitor.Add(server.get());
+  }
+  cout << "Publishing hpx, hpxpy, hprof "
+       << (mfile ? "in " + mapfile : "on port " + to_string(port))
+       << ". Stop with Ctrl-C." << endl;
+
+  TRandom3 rnd(0);
+  Int_t nperinterval = max(1, rate * interval / 1000);
+  for( ;; ) {
+    for( Int_t i = 0; i < nperinterval; ++i ) {
+      Double_t px = rnd.Gaus(), py = rnd.Gaus();
+      hpx->Fill(px);
+      hpxpy->Fill(px, py);
+      hprof->Fill(px, px * px + py * py);
+    }
+    if( mfile ) {
+      mfile->Update();
+      gSystem->Sleep(interval);
+      continue;
+    }
+    // Serve requests until the next fill
+    Long64_t tnext = static_cast<Long64_t>(gSystem->Now()) + interval;
+    for( Long_t wait = interval; wait > 0;
+         wait = tnext - static_cast<Long64_t>(gSystem->Now()) ) {
+      TSocket* sock = monitor.Select(wait);
+      if( !sock || sock == reinterpret_cast<TSocket*>(-1) )
+        break;  // Timeout
+      if( sock == server.get() ) {
+        if( TSocket* client = server->Accept() )
+          monitor.Add(client);
+        continue;
+      }
+      char request[64];
+      if( sock->Recv(request, sizeof(request)) <= 0 ) {
+        monitor.Remove(sock);
+        delete sock;
+        continue;
+      }
+      if( strcmp(request, "get") == 0 ) {
+        TMessage mess(kMESS_OBJECT);
+        mess.WriteObject(&hists);
+        sock->Send(mess);
+      }
+    }
+  }
+}
@@ -0,0 +1,120 @@
+///////////////////////////////////////////////////////////////////
+//  Archive of drawn objects
+///////////////////////////////////////////////////////////////////
+
+#include "panguinArchive.hh"
+#include <TROOT.h>
+#include <TList.h>
+#include <TH1.h>
+#include <TFrame.h>
+#include <TPaveText.h>
+#include <iostream>
+#include <set>
+#include <cstring>
+
+using namespace std;
+
+//_____________________________________________________________________________
+// Create 'file'. 'compression' is a ROOT compression setting (100 *
+// algorithm + level, e.g. 505 for ZSTD level 5); -1 means ROOT's default.
+ArchiveWriter::ArchiveWriter( const string& file, Int_t compression )
+  : fName{file}
+{
+  ROOT::EnableThreadSafety();
+  TDirectory::TContext ctx;  // Keep gDirectory
+  fFile.reset(TFile::Open(file.c_str(), "RECREATE", "panguin plots"));
+  if( !fFile || fFile->IsZombie() ) {
+    cerr << "Error: cannot create archive file " << file << endl;
+    fFile.reset();
+    return;
+  }
+  if( compression >= 0 )
+    fFile->SetCompressionSettings(compression);
+  fThread = thread(&ArchiveWriter::Run, this);
+}
+
+//_____________________________________________________________________________
+ArchiveWriter::~ArchiveWriter()
+{
+  Close();
+}
+
+//_____________________________________________________________________________
+// Queue copies of the objects drawn in 'pad' to be written to directory
+// 'dir'. Axis frames and titles, which ROOT recreates when drawing, are
+// skipped. Objects with the same name get a numeric suffix.
+void ArchiveWriter::AddPad( const string& dir, TVirtualPad* pad )
+{
+  if( !fFile || !pad )
+    return;
+  Item item{dir, {}};
+  set<string> names;
+  TDirectory::TContext ctx(nullptr);  // Clones not attached to any file
+  TIter next(pad->GetListOfPrimitives());
+  while( auto* obj = next() ) {
+    if( dynamic_cast<TFrame*>(obj) ||
+        (dynamic_cast<TPaveText*>(obj) && strcmp(obj->GetName(), "title") == 0) )
+      continue;
+    string name = obj->GetName();
+    if( name.empty() )
+      name = obj->ClassName();
+    for( int i = 1; !names.insert(name).second; ++i )
+      name = string(obj->GetName()) + "_" + to_string(i);
+    TObject* copy = obj->Clone(name.c_str());
+    if( auto* h = dynamic_cast<TH1*>(copy) )
+      h->SetDirectory(nullptr);
+    item.objects.emplace_back(copy);
+  }
+  if( item.objects.empty() )
+    return;
+  {
+    lock_guard<mutex> lock(fMutex);
+    fQueue.push_back(std::move(item));
+  }
+  fCond.notify_one();
+}
+
+//_____________________________________________________________________________
+// Writer thread
+void ArchiveWriter::Run()
+{
+  for( ;; ) {
+    Item item;
+    {
+      unique_lock<mutex> lock(fMutex);
+      fCond.wait(lock, [this] { return fDone || !fQueue.empty(); });
+      if( fQueue.empty() )
+        return;  // Done
+      item = std::move(fQueue.front());
+      fQueue.pop_front();
+    }
+    TDirectory* dir = fFile->GetDirectory(item.dir.c_str());
+    if( !dir )
+      dir = fFile->mkdir(item.dir.c_str());
+    if( !dir )
+      continue;
+    for( const auto& obj: item.objects ) {
+      if( dir->WriteTObject(obj.get(), obj->GetName()) > 0 )
+        ++fNwritten;
+    }
+  }
+}
+
+//_____________________________________________________________________________
+// Write all queued objects and close the file. Returns the number of
+// objects written.
+Int_t ArchiveWriter::Close()
+{
+  if( !fFile )
+    return 0;
+  {
+    lock_guard<mutex> lock(fMutex);
+    fDone = true;
+  }
+  fCond.notify_one();
+  if( fThread.joinable() )
+    fThread.join();
+  fFile->Close();
+  fFile.reset();
+  return fNwritten;
+}
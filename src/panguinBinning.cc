@@ -0,0 +1,218 @@
+///////////////////////////////////////////////////////////////////
+//  Frozen binning of tree draw histograms
+///////////////////////////////////////////////////////////////////
+
+#include "panguinBinning.hh"
+#include <TH1F.h>
+#include <TH2F.h>
+#include <TProfile.h>
+#include <TEnv.h>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <vector>
+#include <cmath>
+
+using namespace std;
+
+// Entries read to determine the axis ranges
+static const Long64_t kSampleEntries = 10000;
+// Fewest selected values for which the ranges are trusted
+static const size_t kMinSample = 100;
+// Fraction of values outside the range, on either side
+static const double kTail = 0.001;
+
+//_____________________________________________________________________________
+// Book an empty histogram with this binning, not attached to any directory
+TH1* Binning::Book( const char* name, const char* title ) const
+{
+  TH1* hist = nullptr;
+  if( ndim == 1 )
+    hist = new TH1F(name, title, nbins[0], lo[0], hi[0]);
+  else if( ndim == 2 )
+    hist = new TH2F(name, title, nbins[0], lo[0], hi[0], nbins[1], lo[1], hi[1]);
+  if( hist )
+    hist->SetDirectory(nullptr);
+  return hist;
+}
+
+//_____________________________________________________________________________
+// True if the axes are the same, wherever the binning came from
+bool Binning::SameAs( const Binning& rhs ) const
+{
+  if( ndim != rhs.ndim )
+    return false;
+  for( Int_t i = 0; i < ndim; ++i ) {
+    if( nbins[i] != rhs.nbins[i] || lo[i] != rhs.lo[i] || hi[i] != rhs.hi[i] )
+      return false;
+  }
+  return true;
+}
+
+//_____________________________________________________________________________
+BinningResolver::BinningResolver( string file )
+  : fFile{std::move(file)}
+{
+  if( !fFile.empty() )
+    Load();
+}
+
+//_____________________________________________________________________________
+// Frozen binning of plot 'key', or nullptr if not resolved yet
+const Binning* BinningResolver::Find( const string& key ) const
+{
+  auto it = fBinning.find(key);
+  return (it != fBinning.end()) ? &it->second : nullptr;
+}
+
+//_____________________________________________________________________________
+// Returns the binning of plot 'key': that of 'golden' if given, which
+// replaces any binning frozen before, otherwise the frozen binning, which is
+// determined from the first entries of 'expr' if not done yet. The result is
+// invalid (and not frozen) if there are too few entries yet.
+const Binning& BinningResolver::Resolve( const string& key, TreeExpr* expr,
+                                         const TH1* golden )
+{
+  static const Binning none;
+  auto it = fBinning.find(key);
+  Binning binning;
+  if( golden && expr && golden->GetDimension() == expr->GetDimension() )
+    binning = FromHist(golden);
+  if( binning.IsValid() ) {
+    if( it == fBinning.end() || !it->second.SameAs(binning) ) {
+      fBinning[key] = binning;
+      Save();
+    }
+    return fBinning[key];
+  }
+  if( it != fBinning.end() )
+    return it->second;
+  binning = FromSample(expr);
+  if( !binning.IsValid() )
+    return none;
+  it = fBinning.emplace(key, binning).first;
+  Save();
+  return it->second;
+}
+
+//_____________________________________________________________________________
+// Binning of 'hist', if it is a 1D or 2D histogram with fixed bin widths
+Binning BinningResolver::FromHist( const TH1* hist )
+{
+  Binning binning;
+  if( !hist || hist->GetDimension() > 2 || dynamic_cast<const TProfile*>(hist) )
+    return binning;
+  const TAxis* axes[2] = {hist->GetXaxis(), hist->GetYaxis()};
+  for( Int_t i = 0; i < hist->GetDimension(); ++i ) {
+    if( axes[i]->IsVariableBinSize() )
+      return binning;
+    binning.nbins[i] = axes[i]->GetNbins();
+    binning.lo[i] = axes[i]->GetXmin();
+    binning.hi[i] = axes[i]->GetXmax();
+  }
+  binning.ndim = hist->GetDimension();
+  binning.source = "golden";
+  return binning;
+}
+
+//_____________________________________________________________________________
+// Axis range covering the bulk of 'val' (which is reordered), with a margin.
+// Integer values spanning fewer than 'nbins' values get one bin each.
+static void FindRange( vector<double>& val, Int_t& nbins, double& lo, double& hi )
+{
+  size_t n = val.size();
+  size_t ilo = static_cast<size_t>(kTail * n);
+  size_t ihi = n - 1 - ilo;
+  nth_element(val.begin(), val.begin() + ilo, val.end());
+  lo = val[ilo];
+  nth_element(val.begin() + ilo, val.begin() + ihi, val.end());
+  hi = val[ihi];
+  bool integer = all_of(val.begin(), val.end(),
+                        []( double v ) { return v == floor(v); });
+  if( integer && hi - lo + 1 <= nbins ) {
+    nbins = static_cast<Int_t>(hi - lo + 1);
+    lo -= 0.5;
+    hi += 0.5;
+    return;
+  }
+  double margin = (hi > lo) ? 0.05 * (hi - lo) : max(1., 0.05 * fabs(lo));
+  lo -= margin;
+  hi += margin;
+}
+
+//_____________________________________________________________________________
+// Binning from the first entries of 'expr': default number of bins, ranges
+// from the 0.1% and 99.9% quantiles of the sampled values plus a margin
+Binning BinningResolver::FromSample( TreeExpr* expr )
+{
+  Binning binning;
+  if( !expr || expr->GetDimension() > 2 )
+    return binning;
+  Int_t ndim = expr->GetDimension();
+  // Variables are given as "y:x"; axis 0 is x
+  vector<double> val[2];
+  Long64_t nsel = expr->Eval(0, kSampleEntries,
+    [ndim, &val]( const Double_t* v, Double_t ) {
+      for( Int_t i = 0; i < ndim; ++i )
+        val[i].push_back(v[ndim - 1 - i]);
+    });
+  if( nsel < 0 || val[0].size() < kMinSample )
+    return binning;
+  if( ndim == 1 ) {
+    binning.nbins[0] = gEnv->GetValue("Hist.Binning.1D.x", 100);
+  } else {
+    binning.nbins[0] = gEnv->GetValue("Hist.Binning.2D.x", 40);
+    binning.nbins[1] = gEnv->GetValue("Hist.Binning.2D.y", 40);
+  }
+  for( Int_t i = 0; i < ndim; ++i )
+    FindRange(val[i], binning.nbins[i], binning.lo[i], binning.hi[i]);
+  binning.ndim = ndim;
+  binning.source = "sample";
+  return binning;
+}
+
+//_____________________________________________________________________________
+// Read the binning frozen in earlier runs. Each line of the cache file has
+// the dimension, bins and limits of each axis, followed by the plot key.
+void BinningResolver::Load()
+{
+  ifstream ifs(fFile);
+  string line;
+  while( getline(ifs, line) ) {
+    istringstream istr(line);
+    Binning binning;
+    istr >> binning.ndim;
+    if( binning.ndim < 1 || binning.ndim > 2 )
+      continue;
+    for( Int_t i = 0; i < binning.ndim; ++i )
+      istr >> binning.nbins[i] >> binning.lo[i] >> binning.hi[i];
+    string key;
+    if( !istr || !getline(istr >> ws, key) || key.empty() )
+      continue;
+    binning.source = "cache";
+    fBinning[key] = binning;
+  }
+}
+
+//_____________________________________________________________________________
+// Write all frozen binning to the cache file, if any
+void BinningResolver::Save() const
+{
+  if( fFile.empty() )
+    return;
+  ofstream ofs(fFile);
+  if( !ofs ) {
+    cerr << "Warning: cannot write binning cache file " << fFile << endl;
+    return;
+  }
+  ofs << setprecision(17);
+  for( const auto& item: fBinning ) {
+    const Binning& b = item.second;
+    ofs << b.ndim;
+    for( Int_t i = 0; i < b.ndim; ++i )
+      ofs << " " << b.nbins[i] << " " << b.lo[i] << " " << b.hi[i];
+    ofs << " " << item.first << endl;
+  }
+}
@@ -0,0 +1,171 @@
+///////////////////////////////////////////////////////////////////
+//  Time budgets for drawing pads and pages
+///////////////////////////////////////////////////////////////////
+
+#include "panguinBudget.hh"
+#include <TString.h>
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+using namespace std;
+
+// Slowest redraw cadence of degraded pads (every N-th update)
+static const Int_t kMaxCadence = 10;
+// Smallest sample fraction of degraded tree draws
+static const Double_t kMinFraction = 1e-4;
+// Time left reported once the budget is used up, so that tree draws still
+// fill their first sample block
+static const Double_t kNoTimeLeft = 1e-6;
+
+//_____________________________________________________________________________
+DrawBudget::DrawBudget( Double_t padtime, Double_t pagetime )
+  : fPadTime{padtime}
+  , fPageTime{pagetime}
+{
+}
+
+//_____________________________________________________________________________
+// Start the page clock. Call before drawing the pads of a page.
+void DrawBudget::StartPage()
+{
+  fPageClock.Start();
+}
+
+//_____________________________________________________________________________
+// Returns true if the pad should not be redrawn in this update, but show
+// its previous contents instead. This is the case for degraded pads between
+// their turns, and for all pads once the page budget is used up. Only call
+// this if the previous contents are available.
+bool DrawBudget::Skip( Int_t page, Int_t pad )
+{
+  if( fPageTime > 0 && Elapsed(fPageClock) > fPageTime )
+    return true;
+  auto it = fPads.find(Key_t(page, pad));
+  if( it == fPads.end() )
+    return false;
+  auto& state = it->second;
+  if( ++state.skipped < state.cadence )
+    return true;
+  state.skipped = 0;
+  return false;
+}
+
+//_____________________________________________________________________________
+// Start the pad clock
+void DrawBudget::StartPad( Int_t page, Int_t pad )
+{
+  fCurrent = Key_t(page, pad);
+  fDrawn = -1;
+  fStopped = false;
+  fPadClock.Start();
+}
+
+//_____________________________________________________________________________
+// Time (s) left for drawing the current pad, limited by both the pad and
+// the page budget. 0 means no limit.
+Double_t DrawBudget::GetTimeLeft()
+{
+  if( fPadTime <= 0 && fPageTime <= 0 )
+    return 0;
+  Double_t left = 1e30;
+  if( fPadTime > 0 )
+    left = fPadTime - Elapsed(fPadClock);
+  if( fPageTime > 0 )
+    left = min(left, fPageTime - Elapsed(fPageClock));
+  return max(left, kNoTimeLeft);
+}
+
+//_____________________________________________________________________________
+// Fraction of the tree entries to draw in the pad
+Double_t DrawBudget::GetFraction( Int_t page, Int_t pad ) const
+{
+  auto it = fPads.find(Key_t(page, pad));
+  return (it != fPads.end()) ? it->second.fraction : 1.0;
+}
+
+//_____________________________________________________________________________
+// Record that the current pad is a tree draw that used 'fraction' of the
+// entries, and whether it was stopped before reaching the requested
+// fraction because the time ran out.
+void DrawBudget::SetTreeDrawn( Double_t fraction, bool stopped )
+{
+  fDrawn = fraction;
+  fStopped = stopped;
+}
+
+//_____________________________________________________________________________
+// Stop the pad clock and adjust the degradation of the current pad.
+// Returns true if the pad took longer than its budget or its tree draw
+// was stopped early.
+bool DrawBudget::EndPad()
+{
+  auto& state = fPads[fCurrent];
+  state.time = fPadClock.RealTime();
+  state.ndraw++;
+  state.cut = fStopped;
+  state.over = (fPadTime > 0 && state.time > fPadTime);
+  if( state.over || state.cut )
+    state.nover++;
+  if( fPadTime <= 0 )
+    return state.cut;
+
+  if( state.over || state.cut ) {
+    if( fDrawn >= 0 ) {
+      // Tree: sample as many entries as fit into the budget, with a margin
+      Double_t drawn = max(fDrawn, kMinFraction);
+      state.fraction = max(kMinFraction,
+                           min(drawn, drawn * 0.8 * fPadTime / state.time));
+    } else {
+      state.cadence = min(kMaxCadence,
+                          static_cast<Int_t>(ceil(state.time / fPadTime)));
+    }
+  } else if( state.time < 0.5 * fPadTime ) {
+    // Fast enough: relax the degradation
+    if( state.fraction < 1 )
+      state.fraction = min(1.0, 2 * state.fraction);
+    if( state.cadence > 1 )
+      state.cadence--;
+  }
+  return state.over || state.cut;
+}
+
+//_____________________________________________________________________________
+// Short description of the degradation of the pad (empty if none)
+string DrawBudget::GetStatus( Int_t page, Int_t pad ) const
+{
+  auto it = fPads.find(Key_t(page, pad));
+  if( it == fPads.end() )
+    return {};
+  const auto& state = it->second;
+  TString status;
+  if( state.over )
+    status = Form("%.2g s, over budget", state.time);
+  else if( state.cut )
+    status = "stopped at budget";
+  if( state.fraction < 1 )
+    status += Form("%ssampling %.2g%% of entries",
+                   status.IsNull() ? "" : ", ", 100 * state.fraction);
+  if( state.cadence > 1 )
+    status += Form("%sredrawn every %d updates",
+                   status.IsNull() ? "" : ", ", state.cadence);
+  return status.Data();
+}
+
+//_____________________________________________________________________________
+// Print the last draw time and the degradation of all pads drawn so far
+void DrawBudget::Report( ostream& os ) const
+{
+  os << "Pad draw times (budget per pad: ";
+  if( fPadTime > 0 ) os << fPadTime << " s"; else os << "none";
+  os << ", per page: ";
+  if( fPageTime > 0 ) os << fPageTime << " s"; else os << "none";
+  os << ")" << endl;
+  os << " page  pad  time (s)  over  status" << endl;
+  for( const auto& pad: fPads ) {
+    const auto& state = pad.second;
+    os << setw(5) << pad.first.first + 1 << setw(5) << pad.first.second
+       << setw(10) << Form("%.3f", state.time) << setw(6) << state.nover
+       << "  " << GetStatus(pad.first.first, pad.first.second) << endl;
+  }
+}
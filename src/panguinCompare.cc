@@ -0,0 +1,175 @@
+///////////////////////////////////////////////////////////////////
+//  Bin-wise comparison maps of histograms vs. golden reference
+///////////////////////////////////////////////////////////////////
+
+#include "panguinCompare.hh"
+#include <TArrayD.h>
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+
+using namespace std;
+
+//_____________________________________________________________________________
+ECompareMode ParseCompareMode( const string& mode )
+{
+  if( mode == "ratio" )
+    return ECompareMode::kRatio;
+  if( mode == "diff" )
+    return ECompareMode::kDiff;
+  if( mode == "pull" )
+    return ECompareMode::kPull;
+  return ECompareMode::kNone;
+}
+
+//_____________________________________________________________________________
+const char* CompareModeName( ECompareMode mode )
+{
+  switch( mode ) {
+    case ECompareMode::kRatio: return "ratio";
+    case ECompareMode::kDiff:  return "diff";
+    case ECompareMode::kPull:  return "pull";
+    default: break;
+  }
+  return "none";
+}
+
+//_____________________________________________________________________________
+// Comparison kernel over contiguous bin arrays. The loops are free of
+// branches and function calls (other than sqrt) so that the compiler can
+// vectorize them. 'scale' normalizes the reference to the current histogram.
+static void CompareKernel( ECompareMode mode, size_t n, double scale,
+                           const double* cur, const double* cur_err2,
+                           const double* ref, const double* ref_err2,
+                           double* out )
+{
+  switch( mode ) {
+    case ECompareMode::kRatio:
+      for( size_t i = 0; i < n; ++i ) {
+        double r = scale * ref[i];
+        double nonzero = (r != 0.0);
+        out[i] = nonzero * cur[i] / (r + (1.0 - nonzero));
+      }
+      break;
+    case ECompareMode::kDiff:
+      for( size_t i = 0; i < n; ++i )
+        out[i] = cur[i] - scale * ref[i];
+      break;
+    case ECompareMode::kPull: {
+      double scale2 = scale * scale;
+      for( size_t i = 0; i < n; ++i ) {
+        double den = cur_err2[i] + scale2 * ref_err2[i];
+        double nonzero = (den > 0.0);
+        out[i] = nonzero * (cur[i] - scale * ref[i])
+                 / sqrt(den + (1.0 - nonzero));
+      }
+      break;
+    }
+    default:
+      fill(out, out + n, 0.0);
+      break;
+  }
+}
+
+//_____________________________________________________________________________
+// Copy contents and squared errors of all cells of 'h' (including under- and
+// overflow) into contiguous arrays, in global bin order. Without Sumw2,
+// Poisson errors are assumed.
+void GoldenCompare::GetBinArrays( const TH1* h, vector<double>& val,
+                                  vector<double>& err2 )
+{
+  auto ncells = static_cast<size_t>(h->GetNcells());
+  val.resize(ncells);
+  err2.resize(ncells);
+  for( size_t i = 0; i < ncells; ++i )
+    val[i] = h->GetBinContent(static_cast<Int_t>(i));
+  const TArrayD* sumw2 = h->GetSumw2();
+  if( h->GetSumw2N() > 0 && sumw2 && static_cast<size_t>(sumw2->fN) == ncells )
+    copy(sumw2->fArray, sumw2->fArray + ncells, err2.begin());
+  else
+    transform(val.begin(), val.end(), err2.begin(),
+              []( double v ) { return abs(v); });
+}
+
+//_____________________________________________________________________________
+// Return the comparison map of 'cur' vs. the golden histogram 'ref'.
+// Returns nullptr if the binnings are incompatible.
+TH1* GoldenCompare::Compare( const TH1* cur, const TH1* ref, ECompareMode mode )
+{
+  if( !cur || !ref || mode == ECompareMode::kNone )
+    return nullptr;
+  if( cur->GetNcells() != ref->GetNcells() ||
+      cur->GetDimension() != ref->GetDimension() )
+    return nullptr;
+
+  if( ref != fRefHist ) {
+    GetBinArrays(ref, fRef, fRefErr2);
+    fRefIntegral = ref->Integral();
+    fRefHist = ref;
+    fCurEntries = -1;  // Force recalculation
+  }
+
+  bool changed = (mode != fMode || !fResult ||
+                  fResult->GetNcells() != cur->GetNcells() ||
+                  cur->GetEntries() != fCurEntries ||
+                  cur->GetSumOfWeights() != fCurSumw);
+  if( !changed )
+    return fResult.get();
+
+  GetBinArrays(cur, fCur, fCurErr2);
+  fCurEntries = cur->GetEntries();
+  fCurSumw = cur->GetSumOfWeights();
+  fMode = mode;
+
+  double curIntegral = cur->Integral();
+  double scale = (fRefIntegral != 0) ? curIntegral / fRefIntegral : 1.0;
+
+  if( !fResult || fResult->GetNcells() != cur->GetNcells() ) {
+    string name = cur->GetName();
+    name += "_golden";
+    fResult.reset(static_cast<TH1*>(cur->Clone(name.c_str())));
+    fResult->SetDirectory(nullptr);
+    fResult->Sumw2(false);
+  }
+  string title = cur->GetTitle();
+  title += " (";
+  title += CompareModeName(mode);
+  title += " to golden)";
+  fResult->SetTitle(title.c_str());
+
+  vector<double> out(fCur.size());
+  CompareKernel(mode, out.size(), scale, fCur.data(), fCurErr2.data(),
+                fRef.data(), fRefErr2.data(), out.data());
+  fResult->SetContent(out.data());
+  fResult->SetEntries(fCurEntries);
+
+  // Symmetric color range for signed comparisons
+  if( mode == ECompareMode::kDiff || mode == ECompareMode::kPull ) {
+    double amax = 0;
+    for( double v: out )
+      amax = max(amax, abs(v));
+    if( amax > 0 ) {
+      fResult->SetMinimum(-amax);
+      fResult->SetMaximum(amax);
+    }
+  } else {
+    fResult->SetMinimum();
+    fResult->SetMaximum();
+  }
+
+  return fResult.get();
+}
+
+//_____________________________________________________________________________
+void GoldenCompare::Clear()
+{
+  fRefHist = nullptr;
+  fRef.clear();
+  fRefErr2.clear();
+  fCur.clear();
+  fCurErr2.clear();
+  fCurEntries = -1;
+  fCurSumw = 0;
+  fMode = ECompareMode::kNone;
+  fResult.reset();
+}
@@ -0,0 +1,129 @@
+///////////////////////////////////////////////////////////////////
+//  Point decimation for dense graphs and scatter plots
+///////////////////////////////////////////////////////////////////
+
+#include "panguinDecimate.hh"
+#include <cmath>
+
+using namespace std;
+
+//_____________________________________________________________________________
+// Min/max decimation. Preserves the visual envelope of a series when drawn
+// with about 'nbuckets' horizontal pixels.
+vector<size_t> DecimateMinMax( const double* y, size_t n, size_t nbuckets )
+{
+  vector<size_t> keep;
+  if( n == 0 )
+    return keep;
+  if( nbuckets == 0 || n <= 2 * nbuckets ) {
+    keep.resize(n);
+    for( size_t i = 0; i < n; ++i )
+      keep[i] = i;
+    return keep;
+  }
+  keep.reserve(2 * nbuckets);
+  for( size_t b = 0; b < nbuckets; ++b ) {
+    size_t lo = b * n / nbuckets, hi = (b + 1) * n / nbuckets;
+    if( lo >= hi )
+      continue;
+    size_t imin = lo, imax = lo;
+    for( size_t i = lo + 1; i < hi; ++i ) {
+      if( y[i] < y[imin] ) imin = i;
+      if( y[i] > y[imax] ) imax = i;
+    }
+    if( imin == imax ) {
+      keep.push_back(imin);
+    } else {
+      keep.push_back(imin < imax ? imin : imax);
+      keep.push_back(imin < imax ? imax : imin);
+    }
+  }
+  return keep;
+}
+
+//_____________________________________________________________________________
+// Largest-Triangle-Three-Buckets (S. Steinarsson, 2013). The first and last
+// points are always kept. The remaining points are split into nout-2 buckets,
+// from each of which the point forming the largest triangle with the point
+// kept from the previous bucket and the average of the next bucket is chosen.
+vector<size_t> DecimateLTTB( const double* x, const double* y, size_t n,
+                             size_t nout )
+{
+  vector<size_t> keep;
+  if( nout < 3 || n <= nout ) {
+    keep.resize(n);
+    for( size_t i = 0; i < n; ++i )
+      keep[i] = i;
+    return keep;
+  }
+  keep.reserve(nout);
+  keep.push_back(0);
+  const double width = static_cast<double>(n - 2) / static_cast<double>(nout - 2);
+  size_t a = 0;
+  for( size_t b = 0; b < nout - 2; ++b ) {
+    size_t lo = static_cast<size_t>(b * width) + 1;
+    size_t hi = static_cast<size_t>((b + 1) * width) + 1;
+    if( hi > n - 1 ) hi = n - 1;
+    size_t nlo = hi;
+    size_t nhi = static_cast<size_t>((b + 2) * width) + 1;
+    if( nhi > n ) nhi = n;
+    double avgx = 0, avgy = 0;
+    for( size_t i = nlo; i < nhi; ++i ) {
+      avgx += x[i];
+      avgy += y[i];
+    }
+    if( nhi > nlo ) {
+      avgx /= static_cast<double>(nhi - nlo);
+      avgy /= static_cast<double>(nhi - nlo);
+    }
+    double maxarea = -1;
+    size_t imax = lo;
+    for( size_t i = lo; i < hi; ++i ) {
+      double area = fabs((x[a] - avgx) * (y[i] - y[a])
+                         - (x[a] - x[i]) * (avgy - y[a]));
+      if( area > maxarea ) {
+        maxarea = area;
+        imax = i;
+      }
+    }
+    keep.push_back(imax);
+    a = imax;
+  }
+  keep.push_back(n - 1);
+  return keep;
+}
+
+//_____________________________________________________________________________
+vector<size_t> DecimatePixelGrid( const double* x, const double* y, size_t n,
+                                  double xmin, double xmax,
+                                  double ymin, double ymax,
+                                  size_t nx, size_t ny )
+{
+  vector<size_t> keep;
+  if( nx == 0 || ny == 0 || !(xmax > xmin) || !(ymax > ymin) ) {
+    keep.resize(n);
+    for( size_t i = 0; i < n; ++i )
+      keep[i] = i;
+    return keep;
+  }
+  vector<bool> occupied(nx * ny, false);
+  const double sx = static_cast<double>(nx) / (xmax - xmin);
+  const double sy = static_cast<double>(ny) / (ymax - ymin);
+  for( size_t i = 0; i < n; ++i ) {
+    double fx = (x[i] - xmin) * sx, fy = (y[i] - ymin) * sy;
+    // Written to also reject NaN
+    if( !(fx >= 0 && fx <= static_cast<double>(nx) &&
+          fy >= 0 && fy <= static_cast<double>(ny)) )
+      continue;
+    auto ix = static_cast<size_t>(fx), iy = static_cast<size_t>(fy);
+    // Include the upper edges
+    if( ix == nx ) --ix;
+    if( iy == ny ) --iy;
+    size_t cell = iy * nx + ix;
+    if( !occupied[cell] ) {
+      occupied[cell] = true;
+      keep.push_back(i);
+    }
+  }
+  return keep;
+}
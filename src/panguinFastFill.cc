@@ -0,0 +1,419 @@
+///////////////////////////////////////////////////////////////////
+//  Fast filling of histograms from plain tree branches
+///////////////////////////////////////////////////////////////////
+
+#include "panguinFastFill.hh"
+#include "panguinFormula.hh"  // BookTreeHist
+#include <TH2.h>
+#include <TProfile.h>
+#include <TProfile2D.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+
+using namespace std;
+
+// Entries read per block
+static const Int_t kBlockSize = 4096;
+
+//_____________________________________________________________________________
+// True if 's' is a plain branch or leaf name, like "x" or "bb.ps.e"
+static bool IsName( const string& s )
+{
+  if( s.empty() || !(isalpha(s[0]) || s[0] == '_') )
+    return false;
+  for( char c: s ) {
+    if( !(isalnum(c) || c == '_' || c == '.') )
+      return false;
+  }
+  return true;
+}
+
+//_____________________________________________________________________________
+// True if 'type' is a numeric type that TLeaf::GetValue converts exactly
+static bool IsNumeric( const char* type )
+{
+  static const char* const types[] = {
+    "Double_t", "Float_t", "Long64_t", "ULong64_t", "Long_t", "ULong_t",
+    "Int_t", "UInt_t", "Short_t", "UShort_t", "Char_t", "UChar_t", "Bool_t",
+    "double", "float", "long long", "unsigned long long", "long",
+    "unsigned long", "int", "unsigned int", "short", "unsigned short",
+    "char", "unsigned char", "bool"
+  };
+  for( const char* t: types ) {
+    if( strcmp(type, t) == 0 )
+      return true;
+  }
+  return false;
+}
+
+//_____________________________________________________________________________
+// Split "y:x" into plain names. Returns false if 'varexp' is anything else.
+static bool SplitNames( const TString& varexp, vector<string>& names )
+{
+  names.clear();
+  string s = varexp.Data();
+  size_t start = 0;
+  while( true ) {
+    size_t colon = s.find(':', start);
+    TString name = s.substr(start, colon - start).c_str();
+    names.push_back(name.Strip(TString::kBoth).Data());
+    if( !IsName(names.back()) || names.size() > 2 )
+      return false;
+    if( colon == string::npos )
+      break;
+    start = colon + 1;
+  }
+  return true;
+}
+
+//_____________________________________________________________________________
+// Parse a cut "branch <op> number". Returns false if 'cut' is anything else.
+bool FastTreeFill::ParseCut( const TString& cut, string& name, ECutOp& op,
+                             Double_t& value )
+{
+  string s = cut.Data();
+  size_t pos = s.find_first_of("<>=!");
+  if( pos == string::npos )
+    return false;
+  size_t len = (pos + 1 < s.size() && s[pos + 1] == '=') ? 2 : 1;
+  string opstr = s.substr(pos, len);
+  if( opstr == "<" )       op = kLT;
+  else if( opstr == "<=" ) op = kLE;
+  else if( opstr == ">" )  op = kGT;
+  else if( opstr == ">=" ) op = kGE;
+  else if( opstr == "==" ) op = kEQ;
+  else if( opstr == "!=" ) op = kNE;
+  else
+    return false;
+  name = TString(s.substr(0, pos).c_str()).Strip(TString::kBoth).Data();
+  TString rhs = TString(s.substr(pos + len).c_str()).Strip(TString::kBoth);
+  if( !IsName(name) || rhs.IsNull() )
+    return false;
+  char* end = nullptr;
+  value = strtod(rhs.Data(), &end);
+  return *end == '\0';
+}
+
+//_____________________________________________________________________________
+// True if 'varexp' and 'cut' have one of the simple forms handled here.
+// Only looks at the syntax; whether the names are numeric branches of a
+// given tree is checked by the constructor.
+bool FastTreeFill::IsSimple( const TString& varexp, const TString& cut )
+{
+  vector<string> names;
+  if( !SplitNames(varexp, names) )
+    return false;
+  if( cut.IsNull() )
+    return true;
+  string name;
+  ECutOp op;
+  Double_t value;
+  return ParseCut(cut, name, op, value);
+}
+
+//_____________________________________________________________________________
+// Set up filling from 'tree'. Check IsValid() for success.
+FastTreeFill::FastTreeFill( TTree* tree, const TString& varexp,
+                            const TString& cut )
+  : fTree{tree}, fVar{-1, -1}
+{
+  vector<string> names;
+  if( !tree || !SplitNames(varexp, names) )
+    return;
+  fDim = static_cast<Int_t>(names.size());
+  for( Int_t i = 0; i < fDim; ++i )
+    fVar[i] = AddColumn(names[i]);
+  if( !cut.IsNull() ) {
+    string name;
+    if( !ParseCut(cut, name, fCutOp, fCutValue) )
+      return;
+    fCutCol = AddColumn(name);
+  }
+  if( tree->LoadTree(0) < 0 )
+    return;
+  fTreeNumber = tree->GetTreeNumber();
+  fValid = Attach();
+}
+
+//_____________________________________________________________________________
+// Index of the column reading 'name', added if not yet present
+Int_t FastTreeFill::AddColumn( const string& name )
+{
+  for( size_t i = 0; i < fCols.size(); ++i ) {
+    if( fCols[i].name == name )
+      return static_cast<Int_t>(i);
+  }
+  fCols.emplace_back();
+  fCols.back().name = name;
+  return static_cast<Int_t>(fCols.size() - 1);
+}
+
+//_____________________________________________________________________________
+// Find the leaves of all columns in the current tree. Returns false unless
+// all of them are scalar numeric leaves.
+bool FastTreeFill::Attach()
+{
+  for( auto& col: fCols ) {
+    col.leaf = fTree->GetLeaf(col.name.c_str());
+    if( !col.leaf || col.leaf->GetLeafCount() || col.leaf->GetLenStatic() != 1 ||
+        col.leaf->InheritsFrom("TLeafC") || !IsNumeric(col.leaf->GetTypeName()) )
+      return false;
+    col.branch = col.leaf->GetBranch();
+  }
+  return true;
+}
+
+//_____________________________________________________________________________
+// Read up to 'n' entries starting at 'first' into the column arrays, one
+// branch after the other, so that each loop only touches the baskets of one
+// branch. Stops at the end of the current file of a TChain. Returns the
+// number of entries read, or -1 on error.
+Int_t FastTreeFill::Read( Long64_t first, Int_t n )
+{
+  Long64_t local = fTree->LoadTree(first);
+  if( local < 0 )
+    return -1;
+  if( fTree->GetTreeNumber() != fTreeNumber ) {
+    // Next file of a TChain
+    fTreeNumber = fTree->GetTreeNumber();
+    if( !Attach() )
+      return -1;
+  }
+  TTree* tree = fTree->GetTree();
+  n = static_cast<Int_t>(min<Long64_t>(n, tree->GetEntries() - local));
+  for( auto& col: fCols ) {
+    col.data.resize(n);
+    Double_t* data = col.data.data();
+    for( Int_t i = 0; i < n; ++i ) {
+      if( col.branch->GetEntry(local + i) < 0 )
+        return -1;
+      data[i] = col.leaf->GetValue(0);
+    }
+  }
+  return n;
+}
+
+//_____________________________________________________________________________
+// Evaluate the cut for the first 'n' entries of the current block
+void FastTreeFill::Select( Int_t n )
+{
+  fWeight.resize(n);
+  Double_t* w = fWeight.data();
+  if( fCutCol < 0 ) {
+    fill(w, w + n, 1.);
+    return;
+  }
+  const Double_t* v = fCols[fCutCol].data.data();
+  const Double_t c = fCutValue;
+  switch( fCutOp ) {
+    case kLT: for( Int_t i = 0; i < n; ++i ) w[i] = (v[i] < c);  break;
+    case kLE: for( Int_t i = 0; i < n; ++i ) w[i] = (v[i] <= c); break;
+    case kGT: for( Int_t i = 0; i < n; ++i ) w[i] = (v[i] > c);  break;
+    case kGE: for( Int_t i = 0; i < n; ++i ) w[i] = (v[i] >= c); break;
+    case kEQ: for( Int_t i = 0; i < n; ++i ) w[i] = (v[i] == c); break;
+    case kNE: for( Int_t i = 0; i < n; ++i ) w[i] = (v[i] != c); break;
+    case kNone: fill(w, w + n, 1.); break;
+  }
+}
+
+//_____________________________________________________________________________
+// Fill the selected entries of the current block one by one. Used while
+// 'hist' still buffers entries to find its axis ranges, and when it needs
+// to extend its axes.
+void FastTreeFill::FillEntries( TH1* hist, Int_t first, Int_t last )
+{
+  const Double_t* v0 = fCols[fVar[0]].data.data();
+  const Double_t* w = fWeight.data();
+  if( fDim == 1 ) {
+    for( Int_t i = first; i < last; ++i ) {
+      if( w[i] != 0 )
+        hist->Fill(v0[i]);
+    }
+  } else {
+    // Variables are given as "y:x", but filled as (x,y)
+    const Double_t* v1 = fCols[fVar[1]].data.data();
+    auto* h2 = static_cast<TH2*>(hist);
+    for( Int_t i = first; i < last; ++i ) {
+      if( w[i] != 0 )
+        h2->Fill(v1[i], v0[i]);
+    }
+  }
+}
+
+//_____________________________________________________________________________
+// Compute bin numbers along 'axis' for 'n' values. Underflows (and NaNs)
+// get bin 0, overflows bin nbins+1, as in TAxis::FindFixBin.
+static void FindBins( const TAxis* axis, const Double_t* x, Int_t n, Int_t* bin )
+{
+  const Double_t nbins = axis->GetNbins();
+  const Double_t xmin = axis->GetXmin();
+  const Double_t scale = nbins / (axis->GetXmax() - xmin);
+  for( Int_t i = 0; i < n; ++i ) {
+    Double_t u = (x[i] - xmin) * scale;
+    u = (u >= 0) ? u : -1.;
+    u = (u < nbins) ? u : nbins;
+    bin[i] = static_cast<Int_t>(u + 1.);
+  }
+}
+
+//_____________________________________________________________________________
+// Add the selected entries in [first,last) of the current block to the 1D
+// histogram 'hist', whose axis range is fixed. Returns the number of
+// selected entries.
+Long64_t FastTreeFill::Kernel1D( TH1* hist, Int_t first, Int_t last )
+{
+  const Int_t n = last - first;
+  const Int_t nbins = hist->GetXaxis()->GetNbins();
+  const Double_t* x = fCols[fVar[0]].data.data() + first;
+  const Double_t* w = fWeight.data() + first;
+  fBin[0].resize(n);
+  Int_t* bin = fBin[0].data();
+  FindBins(hist->GetXaxis(), x, n, bin);
+
+  // Statistics are accumulated for entries within the axis range only, as
+  // in TH1::Fill. All selected entries count in the number of entries.
+  Double_t nsel = 0, nout = 0, sw = 0, swx = 0, swx2 = 0;
+  for( Int_t i = 0; i < n; ++i ) {
+    Double_t in = (bin[i] >= 1 && bin[i] <= nbins) ? w[i] : 0.;
+    Double_t xi = (in != 0) ? x[i] : 0.;
+    nsel += w[i];
+    nout += w[i] - in;
+    sw += in;
+    swx += in * xi;
+    swx2 += in * xi * xi;
+  }
+  if( nout > 0 && hist->CanExtendAllAxes() ) {
+    FillEntries(hist, first, last);
+    return static_cast<Long64_t>(nsel);
+  }
+  fCounts.assign(nbins + 2, 0.);
+  Double_t* counts = fCounts.data();
+  for( Int_t i = 0; i < n; ++i )
+    counts[bin[i]] += w[i];
+
+  Double_t stats[TH1::kNstat] = {0};
+  hist->GetStats(stats);
+  for( Int_t b = 0; b <= nbins + 1; ++b ) {
+    if( counts[b] != 0 )
+      hist->AddBinContent(b, counts[b]);
+  }
+  stats[0] += sw;
+  stats[1] += sw;  // Unit weights: sum of squares equals the sum
+  stats[2] += swx;
+  stats[3] += swx2;
+  hist->PutStats(stats);
+  hist->SetEntries(hist->GetEntries() + nsel);
+  return static_cast<Long64_t>(nsel);
+}
+
+//_____________________________________________________________________________
+// Same as Kernel1D for a 2D histogram of "y:x"
+Long64_t FastTreeFill::Kernel2D( TH1* hist, Int_t first, Int_t last )
+{
+  const Int_t n = last - first;
+  const Int_t nbx = hist->GetXaxis()->GetNbins();
+  const Int_t nby = hist->GetYaxis()->GetNbins();
+  const Double_t* x = fCols[fVar[1]].data.data() + first;
+  const Double_t* y = fCols[fVar[0]].data.data() + first;
+  const Double_t* w = fWeight.data() + first;
+  fBin[0].resize(n);
+  fBin[1].resize(n);
+  Int_t* binx = fBin[0].data();
+  Int_t* biny = fBin[1].data();
+  FindBins(hist->GetXaxis(), x, n, binx);
+  FindBins(hist->GetYaxis(), y, n, biny);
+
+  Double_t nsel = 0, nout = 0, sw = 0, swx = 0, swx2 = 0, swy = 0, swy2 = 0,
+    swxy = 0;
+  for( Int_t i = 0; i < n; ++i ) {
+    Double_t in = (binx[i] >= 1 && binx[i] <= nbx &&
+                   biny[i] >= 1 && biny[i] <= nby) ? w[i] : 0.;
+    Double_t xi = (in != 0) ? x[i] : 0.;
+    Double_t yi = (in != 0) ? y[i] : 0.;
+    nsel += w[i];
+    nout += w[i] - in;
+    sw += in;
+    swx += in * xi;
+    swx2 += in * xi * xi;
+    swy += in * yi;
+    swy2 += in * yi * yi;
+    swxy += in * xi * yi;
+  }
+  if( nout > 0 && hist->CanExtendAllAxes() ) {
+    FillEntries(hist, first, last);
+    return static_cast<Long64_t>(nsel);
+  }
+  const Int_t stride = nbx + 2;
+  fCounts.assign(stride * (nby + 2), 0.);
+  Double_t* counts = fCounts.data();
+  for( Int_t i = 0; i < n; ++i )
+    counts[binx[i] + stride * biny[i]] += w[i];
+
+  Double_t stats[TH1::kNstat] = {0};
+  hist->GetStats(stats);
+  for( Int_t b = 0; b < static_cast<Int_t>(fCounts.size()); ++b ) {
+    if( counts[b] != 0 )
+      hist->AddBinContent(b, counts[b]);
+  }
+  stats[0] += sw;
+  stats[1] += sw;
+  stats[2] += swx;
+  stats[3] += swx2;
+  stats[4] += swy;
+  stats[5] += swy2;
+  stats[6] += swxy;
+  hist->PutStats(stats);
+  hist->SetEntries(hist->GetEntries() + nsel);
+  return static_cast<Long64_t>(nsel);
+}
+
+//_____________________________________________________________________________
+// Add 'n' entries starting at 'first' to 'hist', with the same result as
+// TTree::Draw with ">>+hist". Returns the number of selected entries, or -1
+// if 'hist' is not a plain fixed-binned histogram of the right dimension.
+Long64_t FastTreeFill::Fill( TH1* hist, Long64_t first, Long64_t n )
+{
+  if( !fValid || !hist || hist->GetDimension() != fDim ||
+      dynamic_cast<TProfile*>(hist) || dynamic_cast<TProfile2D*>(hist) ||
+      hist->GetSumw2N() > 0 ||
+      hist->GetXaxis()->IsVariableBinSize() ||
+      (fDim == 2 && hist->GetYaxis()->IsVariableBinSize()) )
+    return -1;
+  Long64_t nsel = 0;
+  Long64_t last = min(first + n, fTree->GetEntries());
+  for( Long64_t start = first; start < last; ) {
+    Int_t len = Read(start, static_cast<Int_t>(min<Long64_t>(kBlockSize, last - start)));
+    if( len <= 0 )
+      break;
+    Select(len);
+    // Automatic axis ranges are determined from the first entries, which
+    // the histogram keeps in a buffer until it is full
+    Int_t i = 0;
+    for( ; i < len && hist->GetBuffer(); ++i ) {
+      if( fWeight[i] != 0 ) {
+        FillEntries(hist, i, i + 1);
+        ++nsel;
+      }
+    }
+    if( i < len )
+      nsel += (fDim == 1) ? Kernel1D(hist, i, len) : Kernel2D(hist, i, len);
+    start += len;
+  }
+  hist->BufferEmpty(1);
+  return nsel;
+}
+
+//_____________________________________________________________________________
+// Book a histogram for 'varexp' and 'cut' like TTree::Draw does: default
+// binning, axis ranges determined from the first entries and extended to
+// later ones as needed, drawing attributes of 'tree'
+TH1* FastTreeFill::Book( const char* name, TTree* tree, const TString& varexp,
+                         const TString& cut )
+{
+  vector<string> names;
+  if( !tree || !SplitNames(varexp, names) )
+    return nullptr;
+  return BookTreeHist(name, tree, varexp, cut);
+}
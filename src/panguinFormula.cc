@@ -0,0 +1,242 @@
+///////////////////////////////////////////////////////////////////
+//  Cache of compiled tree draw expressions
+///////////////////////////////////////////////////////////////////
+
+#include "panguinFormula.hh"
+#include <TTreeFormulaManager.h>
+#include <TH1F.h>
+#include <TH2F.h>
+#include <TEnv.h>
+#include <TH3.h>
+#include <TProfile.h>
+#include <TProfile2D.h>
+
+using namespace std;
+
+//_____________________________________________________________________________
+// Split a "z:y:x" expression at the colons, ignoring scope operators like
+// TMath::Abs and colons inside brackets (e.g. of the ?: operator)
+vector<TString> SplitVarexp( const TString& varexp )
+{
+  vector<TString> vars;
+  Int_t depth = 0;
+  Ssiz_t start = 0;
+  for( Ssiz_t i = 0; i < varexp.Length(); ++i ) {
+    char c = varexp[i];
+    if( c == '(' || c == '[' ) {
+      ++depth;
+    } else if( c == ')' || c == ']' ) {
+      --depth;
+    } else if( c == ':' && depth == 0 ) {
+      if( i + 1 < varexp.Length() && varexp[i + 1] == ':' ) {
+        ++i;
+        continue;
+      }
+      vars.push_back(varexp(start, i - start));
+      start = i + 1;
+    }
+  }
+  vars.push_back(varexp(start, varexp.Length() - start));
+  return vars;
+}
+
+//_____________________________________________________________________________
+// Book a histogram for 'varexp' ("x" or "y:x") and 'cut' like TTree::Draw
+// does: default binning, axis ranges determined from the first entries and
+// extended to later ones as needed, drawing attributes of 'tree'. Returns
+// nullptr for other expressions.
+TH1* BookTreeHist( const char* name, TTree* tree, const TString& varexp,
+                   const TString& cut )
+{
+  auto vars = SplitVarexp(varexp);
+  if( !tree || vars.size() > 2 )
+    return nullptr;
+  TString title = varexp;
+  if( !cut.IsNull() )
+    title += Form(" {%s}", cut.Data());
+  TH1* hist = nullptr;
+  if( vars.size() == 1 ) {
+    hist = new TH1F(name, title, gEnv->GetValue("Hist.Binning.1D.x", 100), 0, 0);
+    hist->GetXaxis()->SetTitle(vars[0].Strip(TString::kBoth));
+  } else {
+    hist = new TH2F(name, title, gEnv->GetValue("Hist.Binning.2D.x", 40), 0, 0,
+                    gEnv->GetValue("Hist.Binning.2D.y", 40), 0, 0);
+    hist->GetXaxis()->SetTitle(vars[1].Strip(TString::kBoth));
+    hist->GetYaxis()->SetTitle(vars[0].Strip(TString::kBoth));
+  }
+  hist->SetDirectory(nullptr);
+  hist->SetCanExtend(TH1::kAllAxes);
+  tree->TAttLine::Copy(*hist);
+  tree->TAttFill::Copy(*hist);
+  tree->TAttMarker::Copy(*hist);
+  return hist;
+}
+
+//_____________________________________________________________________________
+// Compile 'varexp' and 'cut' for 'tree'. Check IsValid() for success.
+// Projections into named histograms (">>") are left to TTree::Draw.
+TreeExpr::TreeExpr( TTree* tree, const TString& varexp, const TString& cut )
+  : fTree{tree}
+{
+  if( !tree || varexp.Contains(">>") )
+    return;
+  auto vars = SplitVarexp(varexp);
+  if( vars.size() > 3 )
+    return;
+  for( size_t i = 0; i < vars.size(); ++i ) {
+    vars[i] = vars[i].Strip(TString::kBoth);
+    if( vars[i].IsNull() )
+      return;
+    fVar.emplace_back(new TreeFormula(Form("var%zu", i), vars[i], tree));
+    if( fVar.back()->GetNdim() == 0 )
+      return;  // Compilation error
+  }
+  if( !cut.IsNull() ) {
+    fCut.reset(new TreeFormula("selection", cut, tree));
+    if( fCut->GetNdim() == 0 )
+      return;
+  }
+  // Synchronize the array sizes of all formulas, like TSelectorDraw. The
+  // manager is owned and eventually deleted by the formulas.
+  auto* manager = new TTreeFormulaManager;
+  if( fCut )
+    manager->Add(fCut.get());
+  for( auto& var: fVar )
+    manager->Add(var.get());
+  manager->Sync();
+  fValid = true;
+}
+
+//_____________________________________________________________________________
+// Use the expression with 'tree', a new object replacing the tree it was
+// compiled for. Returns false if 'tree' lacks any of the branches used.
+bool TreeExpr::Rebind( TTree* tree )
+{
+  if( !fValid )
+    return false;
+  fTree = tree;
+  fTreeNumber = -1;
+  if( fCut ) {
+    fCut->SetTree(tree);
+    fCut->UpdateFormulaLeaves();
+    if( fCut->IsMissingLeaf() )
+      fValid = false;
+  }
+  for( auto& var: fVar ) {
+    var->SetTree(tree);
+    var->UpdateFormulaLeaves();
+    if( var->IsMissingLeaf() )
+      fValid = false;
+  }
+  if( fValid )
+    fVar[0]->GetManager()->Sync();
+  return fValid;
+}
+
+//_____________________________________________________________________________
+// Evaluate the expression for 'n' entries starting at 'first' and call
+// 'fcn' for each selected value. Returns the number of selected values, or
+// -1 if the expression is invalid.
+Long64_t TreeExpr::Eval( Long64_t first, Long64_t n, const Callback_t& fcn )
+{
+  if( !fValid )
+    return -1;
+  Double_t v[3] = {0, 0, 0};
+  Long64_t nsel = 0;
+  Long64_t last = min(first + n, fTree->GetEntries());
+  for( Long64_t entry = first; entry < last; ++entry ) {
+    if( fTree->LoadTree(entry) < 0 )
+      break;
+    if( fTree->GetTreeNumber() != fTreeNumber ) {
+      // Next file of a TChain
+      fTreeNumber = fTree->GetTreeNumber();
+      if( fCut )
+        fCut->UpdateFormulaLeaves();
+      for( auto& var: fVar )
+        var->UpdateFormulaLeaves();
+    }
+    Int_t ndata = fVar[0]->GetManager()->GetNdata();
+    for( Int_t i = 0; i < ndata; ++i ) {
+      Double_t w = fCut ? fCut->EvalInstance(i) : 1.;
+      if( i == 0 ) {
+        // Always evaluate the first instance, to load the branches
+        for( size_t k = 0; k < fVar.size(); ++k )
+          v[k] = fVar[k]->EvalInstance(0);
+        if( w == 0 )
+          continue;
+      } else {
+        if( w == 0 )
+          continue;
+        for( size_t k = 0; k < fVar.size(); ++k )
+          v[k] = fVar[k]->EvalInstance(i);
+      }
+      fcn(v, w);
+      ++nsel;
+    }
+  }
+  return nsel;
+}
+
+//_____________________________________________________________________________
+// Add 'n' entries starting at 'first' to 'hist', as TTree::Draw with
+// ">>+hist" would. Returns the number of selected values, or -1 if 'hist'
+// does not match the dimension of the expression.
+Long64_t TreeExpr::Fill( TH1* hist, Long64_t first, Long64_t n )
+{
+  if( !fValid || !hist )
+    return -1;
+  // Variables are given as "y:x", but filled as (x,y)
+  Callback_t fill;
+  auto* p2 = dynamic_cast<TProfile2D*>(hist);
+  auto* p1 = dynamic_cast<TProfile*>(hist);
+  auto* h3 = dynamic_cast<TH3*>(hist);
+  auto* h2 = dynamic_cast<TH2*>(hist);
+  switch( GetDimension() ) {
+    case 1:
+      if( hist->GetDimension() != 1 || p1 )
+        return -1;
+      fill = [hist]( const Double_t* v, Double_t w ) { hist->Fill(v[0], w); };
+      break;
+    case 2:
+      if( p1 )
+        fill = [p1]( const Double_t* v, Double_t w ) { p1->Fill(v[1], v[0], w); };
+      else if( h2 && !p2 )
+        fill = [h2]( const Double_t* v, Double_t w ) { h2->Fill(v[1], v[0], w); };
+      else
+        return -1;
+      break;
+    case 3:
+      if( p2 )
+        fill = [p2]( const Double_t* v, Double_t w ) { p2->Fill(v[2], v[1], v[0], w); };
+      else if( h3 )
+        fill = [h3]( const Double_t* v, Double_t w ) { h3->Fill(v[2], v[1], v[0], w); };
+      else
+        return -1;
+      break;
+    default:
+      return -1;
+  }
+  return Eval(first, n, fill);
+}
+
+//_____________________________________________________________________________
+// Returns the compiled expression for 'varexp' and 'cut' in 'tree', a tree
+// of the current input file, or nullptr if it cannot be compiled. An
+// expression compiled for the tree of an earlier input file is rebound to
+// 'tree', or compiled again if the branches it uses have changed.
+TreeExpr* FormulaCache::Get( TTree* tree, const TString& varexp,
+                             const TString& cut )
+{
+  if( !tree )
+    return nullptr;
+  Key_t key(tree->GetName(), varexp.Data(), cut.Data());
+  auto& entry = fExpr[key];
+  if( !entry.expr ) {
+    entry.expr.reset(new TreeExpr(tree, varexp, cut));
+  } else if( entry.generation != fGeneration || entry.expr->GetTree() != tree ) {
+    if( !entry.expr->Rebind(tree) )
+      entry.expr.reset(new TreeExpr(tree, varexp, cut));
+  }
+  entry.generation = fGeneration;
+  return entry.expr->IsValid() ? entry.expr.get() : nullptr;
+}
@@ -0,0 +1,187 @@
+///////////////////////////////////////////////////////////////////
+//  Delta-encoded history of histogram snapshots for the monitor
+///////////////////////////////////////////////////////////////////
+
+#include "panguinHistory.hh"
+#include <TAxis.h>
+#include <sstream>
+#include <limits>
+
+using namespace std;
+
+// Approximate bookkeeping overhead per stored delta
+static const size_t kDeltaOverhead = sizeof(time_t) + sizeof(double)
+                                     + 2 * sizeof(vector<double>);
+
+//_____________________________________________________________________________
+// Axis ranges and bin counts. If these change, stored snapshots are useless.
+string HistHistory::BinningSignature( const TH1* h )
+{
+  ostringstream ostr;
+  const TAxis* axes[] = {h->GetXaxis(), h->GetYaxis(), h->GetZaxis()};
+  for( const auto* ax: axes ) {
+    ostr << ax->GetNbins() << ":" << ax->GetXmin() << ":" << ax->GetXmax()
+         << ";";
+  }
+  return ostr.str();
+}
+
+//_____________________________________________________________________________
+// Add a snapshot of 'h' taken at time 't' to the track 'key'
+void HistHistory::Record( const string& key, const TH1* h, time_t t )
+{
+  if( !h )
+    return;
+  auto ncells = static_cast<size_t>(h->GetNcells());
+  if( fBudget > 0 && ncells * sizeof(double) > fBudget )
+    return;  // Histogram alone exceeds the budget
+
+  string binning = BinningSignature(h);
+  auto& track = fTracks[key];
+  if( track.binning != binning || track.latest.size() != ncells ) {
+    // New track or binning changed: start over
+    fUsage -= track.bytes;
+    track = Track{};
+    track.binning = std::move(binning);
+    track.latest.resize(ncells);
+    for( size_t i = 0; i < ncells; ++i )
+      track.latest[i] = h->GetBinContent(static_cast<Int_t>(i));
+    track.time = t;
+    track.entries = h->GetEntries();
+    track.bytes = ncells * sizeof(double);
+    fUsage += track.bytes;
+    Shrink();
+    return;
+  }
+  if( t <= track.time )
+    return;
+
+  // Store the previous snapshot as a delta relative to the new one
+  Delta delta;
+  delta.time = track.time;
+  delta.entries = track.entries;
+  for( size_t i = 0; i < ncells; ++i ) {
+    double val = h->GetBinContent(static_cast<Int_t>(i));
+    double diff = track.latest[i] - val;
+    if( diff != 0 ) {
+      delta.index.push_back(static_cast<uint32_t>(i));
+      delta.diff.push_back(diff);
+      track.latest[i] = val;
+    }
+  }
+  delta.index.shrink_to_fit();
+  delta.diff.shrink_to_fit();
+  size_t bytes = kDeltaOverhead
+                 + delta.index.size() * (sizeof(uint32_t) + sizeof(double));
+  track.older.push_back(std::move(delta));
+  track.time = t;
+  track.entries = h->GetEntries();
+  track.bytes += bytes;
+  fUsage += bytes;
+  Shrink();
+}
+
+//_____________________________________________________________________________
+// Reconstruct the contents of track 'key' as of time 'when', i.e. from the
+// newest snapshot taken at or before 'when' (or the oldest one available).
+// Returns the time of the snapshot used, or 0 if the track is unknown.
+time_t HistHistory::GetContents( const string& key, time_t when,
+                                 vector<double>& contents,
+                                 double& entries ) const
+{
+  auto it = fTracks.find(key);
+  if( it == fTracks.end() )
+    return 0;
+  const auto& track = it->second;
+  contents = track.latest;
+  entries = track.entries;
+  time_t t = track.time;
+  for( auto jt = track.older.rbegin(); jt != track.older.rend() && t > when;
+       ++jt ) {
+    const auto& delta = *jt;
+    for( size_t i = 0; i < delta.index.size(); ++i )
+      contents[delta.index[i]] += delta.diff[i];
+    entries = delta.entries;
+    t = delta.time;
+  }
+  return t;
+}
+
+//_____________________________________________________________________________
+// Time of the newest snapshot of any track taken before 'when', or 0 if none
+time_t HistHistory::GetOlder( time_t when ) const
+{
+  time_t older = 0;
+  for( const auto& item: fTracks ) {
+    const auto& track = item.second;
+    if( track.time < when && track.time > older )
+      older = track.time;
+    for( auto jt = track.older.rbegin(); jt != track.older.rend(); ++jt ) {
+      if( jt->time < when ) {
+        if( jt->time > older )
+          older = jt->time;
+        break;
+      }
+    }
+  }
+  return older;
+}
+
+//_____________________________________________________________________________
+// Time of the oldest snapshot of any track taken after 'when', or 0 if none
+time_t HistHistory::GetNewer( time_t when ) const
+{
+  time_t newer = numeric_limits<time_t>::max();
+  for( const auto& item: fTracks ) {
+    const auto& track = item.second;
+    for( const auto& delta: track.older ) {
+      if( delta.time > when ) {
+        if( delta.time < newer )
+          newer = delta.time;
+        break;
+      }
+    }
+    if( track.time > when && track.time < newer )
+      newer = track.time;
+  }
+  return newer == numeric_limits<time_t>::max() ? 0 : newer;
+}
+
+//_____________________________________________________________________________
+// Discard the oldest snapshots until the memory use is within the budget.
+// If only full snapshots remain, drop the least recently updated tracks.
+void HistHistory::Shrink()
+{
+  if( fBudget == 0 )
+    return;
+  while( fUsage > fBudget && !fTracks.empty() ) {
+    auto oldest = fTracks.end(), stalest = fTracks.end();
+    for( auto it = fTracks.begin(); it != fTracks.end(); ++it ) {
+      const auto& track = it->second;
+      if( !track.older.empty() && (oldest == fTracks.end() ||
+          track.older.front().time < oldest->second.older.front().time) )
+        oldest = it;
+      if( stalest == fTracks.end() || track.time < stalest->second.time )
+        stalest = it;
+    }
+    if( oldest != fTracks.end() ) {
+      auto& track = oldest->second;
+      const auto& delta = track.older.front();
+      size_t bytes = kDeltaOverhead
+                     + delta.index.size() * (sizeof(uint32_t) + sizeof(double));
+      track.older.pop_front();
+      track.bytes -= bytes;
+      fUsage -= bytes;
+    } else {
+      fUsage -= stalest->second.bytes;
+      fTracks.erase(stalest);
+    }
+  }
+}
+
+//_____________________________________________________________________________
+void HistHistory::Clear()
+{
+  fTracks.clear();
+  fUsage = 0;
+}
@@ -0,0 +1,168 @@
+///////////////////////////////////////////////////////////////////
+//  JSON output for display with JSROOT
+///////////////////////////////////////////////////////////////////
+
+#include "panguinJSON.hh"
+#include <TBufferJSON.h>
+#include <TVirtualPad.h>
+#include <TDatime.h>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+using namespace std;
+
+// Viewer for the exported pages. %JSROOT% is replaced by the location of
+// JSROOT, by default its official site.
+static const char* const kDefaultJsroot = "https://root.cern/js/latest";
+static const char* const kIndexHtml = R"html(<!DOCTYPE html>
+<html>
+<head>
+<meta charset="utf-8">
+<title>panguin</title>
+<style>
+  body { font-family: sans-serif; margin: 0; display: flex; height: 100vh; }
+  #pages { width: 16em; overflow-y: auto; border-right: 1px solid #ccc; }
+  #pages div { padding: 4px 8px; cursor: pointer; }
+  #pages div.sel { background: #cde; }
+  #main { flex: 1; display: flex; flex-direction: column; }
+  #head { padding: 4px 8px; font-size: small; }
+  #grid { flex: 1; display: grid; }
+  #grid > div { position: relative; min-height: 0; }
+</style>
+</head>
+<body>
+<div id="pages"></div>
+<div id="main"><div id="head"></div><div id="grid"></div></div>
+<script type="module">
+import { parse, draw, cleanup } from '%JSROOT%/modules/main.mjs';
+
+const manifest = await (await fetch('manifest.json')).json();
+const list = document.getElementById('pages');
+const grid = document.getElementById('grid');
+const head = document.getElementById('head');
+document.title = manifest.title;
+
+async function show(n) {
+  const page = manifest.pages[n];
+  [...list.children].forEach((e, i) => e.className = (i == n) ? 'sel' : '');
+  head.textContent = page.heading;
+  [...grid.children].forEach(e => cleanup(e));
+  grid.innerHTML = '';
+  grid.style.gridTemplateColumns = `repeat(${page.nx}, 1fr)`;
+  grid.style.gridTemplateRows = `repeat(${page.ny}, 1fr)`;
+  const divs = page.pads.map(() => grid.appendChild(document.createElement('div')));
+  await Promise.all(page.pads.map(async (file, i) =>
+    draw(divs[i], parse(await (await fetch(file)).text()))));
+}
+
+manifest.pages.forEach((page, i) => {
+  const e = list.appendChild(document.createElement('div'));
+  e.textContent = `${i + 1}: ${page.title}`;
+  e.onclick = () => show(i);
+});
+if (manifest.pages.length > 0)
+  show(0);
+</script>
+</body>
+</html>
+)html";
+
+//_____________________________________________________________________________
+// Quote 'str' as a JSON string
+static string JsonString( const string& str )
+{
+  ostringstream ostr;
+  ostr << '"';
+  for( char c: str ) {
+    switch( c ) {
+      case '"':  ostr << "\\\""; break;
+      case '\\': ostr << "\\\\"; break;
+      case '\n': ostr << "\\n"; break;
+      case '\t': ostr << "\\t"; break;
+      default:
+        if( static_cast<unsigned char>(c) < 0x20 )
+          ostr << ' ';
+        else
+          ostr << c;
+    }
+  }
+  ostr << '"';
+  return ostr.str();
+}
+
+//_____________________________________________________________________________
+// Write JSON files to directory 'dir', which must exist. With 'compress',
+// arrays are written in the compressed form understood by JSROOT (leading
+// and trailing zeros dropped, runs of equal values combined). Either way,
+// whitespace is omitted. The viewer loads JSROOT from 'jsroot', e.g. a
+// local copy on a network without internet access.
+JsonExport::JsonExport( string dir, bool compress, string jsroot )
+  : fDir{std::move(dir)}
+  , fJsroot{jsroot.empty() ? kDefaultJsroot : std::move(jsroot)}
+  , fCompact{compress ? TBufferJSON::kNoSpaces + TBufferJSON::kSameSuppression
+                      : TBufferJSON::kNoSpaces}
+{
+  while( fJsroot.size() > 1 && fJsroot.back() == '/' )
+    fJsroot.pop_back();
+}
+
+//_____________________________________________________________________________
+bool JsonExport::WriteFile( const string& name, const TString& contents ) const
+{
+  string path = fDir + "/" + name;
+  ofstream ofs(path);
+  if( !(ofs << contents.Data()) ) {
+    cerr << "Error writing " << path << endl;
+    return false;
+  }
+  return true;
+}
+
+//_____________________________________________________________________________
+// Write the pads of 'canvas', which has been divided into nx*ny pads, and
+// add the page to the manifest. The viewer shows 'heading' above the pads.
+// Returns the number of pads written.
+Int_t JsonExport::AddPage( const TString& title, const TString& heading,
+                           TCanvas* canvas, Int_t nx, Int_t ny )
+{
+  Page page{title.Data(), heading.Data(), nx, ny, {}};
+  Int_t npage = static_cast<Int_t>(fPages.size()) + 1;
+  for( Int_t i = 1; i <= nx * ny; ++i ) {
+    TVirtualPad* pad = canvas->GetPad(i);
+    if( !pad )
+      break;
+    string name = Form("page%02d_pad%02d.json", npage, i);
+    if( WriteFile(name, TBufferJSON::ConvertToJSON(pad, fCompact)) )
+      page.pads.push_back(name);
+  }
+  fPages.push_back(std::move(page));
+  return static_cast<Int_t>(fPages.back().pads.size());
+}
+
+//_____________________________________________________________________________
+// Write the manifest and the viewer index.html
+bool JsonExport::Close( const TString& title, Int_t run, const string& config )
+{
+  ostringstream ostr;
+  ostr << "{\"title\":" << JsonString(title.Data())
+       << ",\"run\":" << run
+       << ",\"config\":" << JsonString(config)
+       << ",\"created\":" << JsonString(TDatime().AsSQLString())
+       << ",\"pages\":[";
+  for( size_t i = 0; i < fPages.size(); ++i ) {
+    const auto& page = fPages[i];
+    ostr << (i > 0 ? "," : "")
+         << "{\"title\":" << JsonString(page.title)
+         << ",\"heading\":" << JsonString(page.heading)
+         << ",\"nx\":" << page.nx << ",\"ny\":" << page.ny << ",\"pads\":[";
+    for( size_t j = 0; j < page.pads.size(); ++j )
+      ostr << (j > 0 ? "," : "") << JsonString(page.pads[j]);
+    ostr << "]}";
+  }
+  ostr << "]}\n";
+  TString html = kIndexHtml;
+  html.ReplaceAll("%JSROOT%", fJsroot.c_str());
+  return WriteFile("manifest.json", ostr.str().c_str()) &&
+         WriteFile("index.html", html);
+}
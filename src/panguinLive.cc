@@ -0,0 +1,193 @@
+///////////////////////////////////////////////////////////////////
+//  Histograms from shared memory or a socket
+///////////////////////////////////////////////////////////////////
+
+#include "panguinLive.hh"
+#include <TMapFile.h>
+#include <TMemFile.h>
+#include <TMessage.h>
+#include <TList.h>
+#include <TH1.h>
+#include <TCanvas.h>
+#include <TParameter.h>
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+// Time to wait for the publisher's reply (ms)
+static const Long_t kReplyTimeout = 2000;
+
+//_____________________________________________________________________________
+// Write 'obj' to 'file' under 'path' (dir/name), creating directories as
+// needed. The object is owned by the file afterwards.
+static void AddToFile( TFile* file, const string& path, TH1* obj )
+{
+  TDirectory* dir = file;
+  auto pos = path.rfind('/');
+  if( pos != string::npos ) {
+    string dirname = path.substr(0, pos);
+    dir = file->GetDirectory(dirname.c_str());
+    if( !dir )
+      dir = file->mkdir(dirname.c_str());
+  }
+  dir->WriteTObject(obj, path.substr(pos + 1).c_str());
+  obj->SetDirectory(dir);  // Found by Get() without reading the key back
+}
+
+//_____________________________________________________________________________
+LiveSource::LiveSource( const string& spec )
+{
+  if( spec.compare(0, 8, "mapfile:") == 0 && spec.size() > 8 ) {
+    fType = kMapFile;
+    fName = spec.substr(8);
+  } else if( spec.compare(0, 7, "socket:") == 0 ||
+             spec.compare(0, 7, "server:") == 0 ) {
+    auto pos = spec.rfind(':');
+    fPort = atoi(spec.c_str() + pos + 1);
+    fName = pos > 7 ? spec.substr(7, pos - 7) : string("localhost");
+    if( fPort > 0 )
+      fType = (spec.compare(0, 7, "socket:") == 0) ? kSocket : kServer;
+  }
+  if( fType == kNone )
+    cerr << "Error: invalid live source \"" << spec << "\", expect "
+         << "mapfile:<file>, socket:<host>:<port> or server:<host>:<port>"
+         << endl;
+}
+
+//_____________________________________________________________________________
+LiveSource::~LiveSource()
+{
+  if( fMapFile )
+    fMapFile->Close();
+}
+
+//_____________________________________________________________________________
+// Names of the objects to read. Map files cannot be listed cheaply, so only
+// these are looked up. Sockets always deliver all published objects.
+void LiveSource::SetSelection( const vector<string>& names )
+{
+  fSelection = names;
+}
+
+//_____________________________________________________________________________
+bool LiveSource::ReadMapFile( TDirectory* dir )
+{
+  if( !fMapFile ) {
+    fMapFile = TMapFile::Create(fName.c_str());
+    if( !fMapFile ) {
+      cerr << "Cannot open map file " << fName << endl;
+      return false;
+    }
+  }
+  bool found = false;
+  for( const auto& name: fSelection ) {
+    // Get() returns a private copy, made while the producer is locked out
+    auto* h = dynamic_cast<TH1*>(fMapFile->Get(name.c_str()));
+    if( h ) {
+      AddToFile(static_cast<TFile*>(dir), name, h);
+      found = true;
+    }
+  }
+  return found;
+}
+
+//_____________________________________________________________________________
+// Send 'request' to the publisher and wait for its reply. Connects first,
+// if necessary. Returns nullptr on error.
+unique_ptr<TMessage> LiveSource::Request( const char* request )
+{
+  if( !fSocket || !fSocket->IsValid() ) {
+    fSocket.reset(new TSocket(fName.c_str(), fPort));
+    if( !fSocket->IsValid() ) {
+      cerr << "Cannot connect to publisher at " << fName << ":" << fPort
+           << endl;
+      fSocket.reset();
+      return nullptr;
+    }
+  }
+  TMessage* mess = nullptr;
+  if( fSocket->Send(request) <= 0 ||
+      fSocket->Select(TSocket::kRead, kReplyTimeout) != 1 ||
+      fSocket->Recv(mess) <= 0 || !mess ) {
+    cerr << "No reply from publisher at " << fName << ":" << fPort << endl;
+    fSocket.reset();  // Reconnect next time
+    delete mess;
+    return nullptr;
+  }
+  return unique_ptr<TMessage>(mess);
+}
+
+//_____________________________________________________________________________
+bool LiveSource::ReadSocket( TDirectory* dir )
+{
+  unique_ptr<TMessage> msg = Request("get");
+  if( !msg || msg->What() != kMESS_OBJECT )
+    return false;
+  unique_ptr<TList> list(dynamic_cast<TList*>(msg->ReadObject(msg->GetClass())));
+  if( !list )
+    return false;
+  bool found = false;
+  while( auto* obj = list->First() ) {
+    list->Remove(obj);
+    if( auto* h = dynamic_cast<TH1*>(obj) ) {
+      AddToFile(static_cast<TFile*>(dir), h->GetName(), h);
+      found = true;
+    } else {
+      delete obj;
+    }
+  }
+  return found;
+}
+
+//_____________________________________________________________________________
+// Read the currently published objects into a new in-memory file, owned by
+// the caller. Returns nullptr if nothing could be read.
+TFile* LiveSource::Open()
+{
+  if( fType == kNone )
+    return nullptr;
+  auto* file = new TMemFile("panguin_live.root", "RECREATE", "", 0);
+  if( fType == kServer )
+    return file;  // Nothing to copy. Pages are fetched with FetchPage()
+  bool ok = (fType == kMapFile) ? ReadMapFile(file) : ReadSocket(file);
+  if( !ok ) {
+    delete file;
+    return nullptr;
+  }
+  fUpdateTime = time(nullptr);
+  return file;
+}
+
+//_____________________________________________________________________________
+// Fetch page 'page' (0, 1, ...) as last drawn by the panguin server. Returns
+// the page's canvas, owned by the caller, or nullptr if not available. Sets
+// 'run' to the run number of the server's input.
+TCanvas* LiveSource::FetchPage( Int_t page, Int_t& run )
+{
+  if( fType != kServer )
+    return nullptr;
+  unique_ptr<TMessage> msg = Request(Form("page %d", page + 1));
+  if( !msg || msg->What() != kMESS_OBJECT )
+    return nullptr;
+  unique_ptr<TList> list(dynamic_cast<TList*>(msg->ReadObject(msg->GetClass())));
+  if( !list )
+    return nullptr;
+  list->SetOwner();
+  TCanvas* canvas = nullptr;
+  TIter next(list.get());
+  while( auto* obj = next() ) {
+    if( auto* c = dynamic_cast<TCanvas*>(obj) ) {
+      canvas = c;
+    } else if( auto* par = dynamic_cast<TParameter<Long64_t>*>(obj) ) {
+      if( strcmp(par->GetName(), "run") == 0 )
+        run = static_cast<Int_t>(par->GetVal());
+      else if( strcmp(par->GetName(), "updated") == 0 )
+        fUpdateTime = static_cast<time_t>(par->GetVal());
+    }
+  }
+  if( canvas )
+    list->Remove(canvas);
+  return canvas;
+}
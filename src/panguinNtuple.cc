@@ -0,0 +1,203 @@
+///////////////////////////////////////////////////////////////////
+//  RNTuple input
+///////////////////////////////////////////////////////////////////
+
+#include "panguinNtuple.hh"
+#include <TFile.h>
+#include <TKey.h>
+#include <TEnv.h>
+#ifdef PANGUIN_RNTUPLE
+#include <ROOT/RNTupleReader.hxx>
+#include <ROOT/RDataFrame.hxx>
+#endif
+#include <iostream>
+#include <algorithm>
+
+using namespace std;
+
+//_____________________________________________________________________________
+// Split a TTree::Draw-style expression "y:x" into its parts, ignoring
+// scope operators like TMath::Abs
+static vector<TString> SplitExpression( const TString& expr )
+{
+  vector<TString> parts;
+  Ssiz_t start = 0;
+  for( Ssiz_t i = 0; i < expr.Length(); ++i ) {
+    if( expr[i] == ':' ) {
+      if( i + 1 < expr.Length() && expr[i+1] == ':' ) {
+        ++i;
+      } else {
+        parts.emplace_back(expr(start, i - start));
+        start = i + 1;
+      }
+    }
+  }
+  parts.emplace_back(expr(start, expr.Length() - start));
+  return parts;
+}
+
+//_____________________________________________________________________________
+// Check if 'classname' (of a key) is an RNTuple, e.g. "ROOT::RNTuple" or
+// "ROOT::Experimental::RNTuple", depending on the ROOT version that wrote it
+bool NtupleSource::IsNtupleClass( const TString& classname )
+{
+  return classname.EndsWith("::RNTuple");
+}
+
+//_____________________________________________________________________________
+bool NtupleSource::IsSupported()
+{
+#ifdef PANGUIN_RNTUPLE
+  return true;
+#else
+  return false;
+#endif
+}
+
+//_____________________________________________________________________________
+void NtupleSource::ScanDirectory( TDirectory* dir, const string& path, // NOLINT(*-no-recursion)
+                                  const string& file )
+{
+  TIter next(dir->GetListOfKeys());
+  while( auto* key = static_cast<TKey*>(next()) ) {
+    string name = path.empty() ? key->GetName() : path + "/" + key->GetName();
+    TString cl = key->GetClassName();
+    if( cl.BeginsWith("TDirectory") ) {
+      if( auto* subdir = dir->GetDirectory(key->GetName()) )
+        ScanDirectory(subdir, name, file);
+      continue;
+    }
+    if( !IsNtupleClass(cl) )
+      continue;
+    auto it = find_if(fNtuples.begin(), fNtuples.end(),
+                      [&name]( const Ntuple& nt ) { return nt.name == name; });
+    if( it != fNtuples.end() )
+      continue;  // Older cycle
+    Ntuple ntuple{name, {}};
+#ifdef PANGUIN_RNTUPLE
+    try {
+      auto reader = ROOT::RNTupleReader::Open(name, file);
+      const auto& desc = reader->GetDescriptor();
+      // Breadth-first walk through all (sub)fields
+      vector<ROOT::DescriptorId_t> ids{desc.GetFieldZeroId()};
+      for( size_t i = 0; i < ids.size(); ++i ) {
+        for( const auto& field: desc.GetFieldIterable(ids[i]) ) {
+          ntuple.fields.push_back(desc.GetQualifiedFieldName(field.GetId()));
+          ids.push_back(field.GetId());
+        }
+      }
+    }
+    catch( const exception& e ) {
+      cerr << "Error reading RNTuple " << name << ": " << e.what() << endl;
+      continue;
+    }
+#else
+    cerr << "Warning: RNTuple " << name << " found, but this panguin was "
+         << "built without RNTuple support (needs ROOT 6.34 or later)" << endl;
+#endif
+    fNtuples.push_back(std::move(ntuple));
+  }
+}
+
+//_____________________________________________________________________________
+// Find the RNTuples in 'files' and index their fields. All files are
+// assumed to have the same structure, so only the first one is scanned.
+// Nothing is done if the same files were scanned before; use Clear() to
+// force a new scan.
+void NtupleSource::Scan( const vector<string>& files )
+{
+  if( !fScanned.empty() && files == fScanned )
+    return;
+  Clear();
+  if( files.empty() )
+    return;
+  unique_ptr<TFile> f(TFile::Open(files[0].c_str(), "READ"));
+  if( !f || f->IsZombie() )
+    return;
+  fScanned = files;
+  ScanDirectory(f.get(), "", files[0]);
+  if( !fNtuples.empty() )
+    fFiles = files;
+}
+
+//_____________________________________________________________________________
+// Index of the RNTuple called 'name', if given, otherwise of the one with
+// the field of the first variable of 'var' (like OnlineGUI::GetTreeIndex).
+// Returns -1 if not found.
+Int_t NtupleSource::FindIndex( const TString& var, const string& name ) const
+{
+  string svar{var.Data()};
+  auto pos = svar.find_first_of(":-/*+([");
+  if( pos != string::npos )
+    svar.erase(pos);
+  for( size_t i = 0; i < fNtuples.size(); ++i ) {
+    const auto& nt = fNtuples[i];
+    if( name.empty() ? find(nt.fields.begin(), nt.fields.end(), svar) !=
+                       nt.fields.end()
+                     : nt.name == name )
+      return static_cast<Int_t>(i);
+  }
+  return -1;
+}
+
+//_____________________________________________________________________________
+// Fill a histogram of the 1D or 2D expression 'varexp' from RNTuple 'i'
+// with the selection 'cut', like TTree::Draw would. The expressions are
+// compiled as C++ by RDataFrame, which accepts most TTree::Draw formulas.
+// 'nsel' is set to the number of selected entries, or -1 on error.
+unique_ptr<TH1> NtupleSource::Draw( Int_t i, const TString& varexp,
+                                    const TCut& cut, Long64_t& nsel ) const
+{
+  nsel = -1;
+  vector<TString> parts = SplitExpression(varexp);
+  if( i < 0 || i >= static_cast<Int_t>(fNtuples.size()) ||
+      parts.size() > 2 || varexp.Contains(">>") )
+    return nullptr;
+  TString title = varexp;
+  if( strlen(cut.GetTitle()) > 0 )
+    title += Form(" {%s}", cut.GetTitle());
+  unique_ptr<TH1> h;
+#ifdef PANGUIN_RNTUPLE
+  try {
+    ROOT::RDataFrame df(fNtuples[i].name, fFiles);
+    ROOT::RDF::RNode node = df;
+    if( strlen(cut.GetTitle()) > 0 )
+      node = node.Filter(cut.GetTitle());
+    // Axis range 0..0: determined from the data, as in TTree::Draw
+    if( parts.size() == 1 ) {
+      auto res = node.Define("panguin_x", parts[0].Data())
+        .Histo1D({"htemp", title, gEnv->GetValue("Hist.Binning.1D.x", 100),
+                  0, 0}, "panguin_x");
+      TDirectory::TContext ctx(nullptr);
+      h.reset(static_cast<TH1*>(res->Clone("htemp")));
+      h->GetXaxis()->SetTitle(parts[0]);
+    } else {
+      auto res = node.Define("panguin_x", parts[1].Data())
+        .Define("panguin_y", parts[0].Data())
+        .Histo2D({"htemp", title, gEnv->GetValue("Hist.Binning.2D.x", 40),
+                  0, 0, gEnv->GetValue("Hist.Binning.2D.y", 40), 0, 0},
+                 "panguin_x", "panguin_y");
+      TDirectory::TContext ctx(nullptr);
+      h.reset(static_cast<TH1*>(res->Clone("htemp")));
+      h->GetXaxis()->SetTitle(parts[1]);
+      h->GetYaxis()->SetTitle(parts[0]);
+    }
+    nsel = static_cast<Long64_t>(h->GetEntries());
+  }
+  catch( const exception& e ) {
+    cerr << "Error drawing " << varexp << " from RNTuple "
+         << fNtuples[i].name << ": " << e.what() << endl;
+    h.reset();
+    nsel = -1;
+  }
+#endif
+  return h;
+}
+
+//_____________________________________________________________________________
+void NtupleSource::Clear()
+{
+  fFiles.clear();
+  fScanned.clear();
+  fNtuples.clear();
+}
@@ -4,6 +4,12 @@
 ///////////////////////////////////////////////////////////////////
 
 #include "panguinOnline.hh"
+#include "panguinDecimate.hh"
+#include "panguinJSON.hh"
+#include "panguinArchive.hh"
+#include "panguinFastFill.hh"
+#include "panguinParallel.hh"
+#include <RConfigure.h>  // R__USE_IMT
 #include <TBranch.h>
 #include <TGClient.h>
 #include <TCanvas.h>
@@ -12,18 +18,25 @@
 #include <TGImageMap.h>
 #include <TGFileDialog.h>
 #include <TKey.h>
+#include <TList.h>
 #include <TSystem.h>
 #include <TLatex.h>
+#include <TText.h>
+#include <TGraph.h>
+#include <TImage.h>
+#include <TLegend.h>
+#include <TMemFile.h>
 #include "TPaveText.h"
 #include <TApplication.h>
 #include "TEnv.h"
 #include "TRegexp.h"
-#include "TGaxis.h"
 #include <string>
 #include <sstream>
 #include <iostream>
 #include <iomanip>
 #include <list>
+#include <algorithm>
+#include <cmath>
 #include <sys/stat.h>
 #include <ctime>
 #include <utility>
@@ -108,6 +121,29 @@ static inline string StripExtension( string str )
   return str;
 }
 
+//_____________________________________________________________________________
+// True if 'format' (a file extension) is a vector graphics format, where
+// dense pads are rasterized
+static bool IsVectorFormat( TString format )
+{
+  format.ToLower();
+  return format == "pdf" || format == "ps" || format == "eps" ||
+         format == "svg";
+}
+
+//_____________________________________________________________________________
+// Read the keys of 'file' and return their number. The keys of an in-memory
+// file (merged segments, live source) exist only in its list of keys, which ReadKeys()
+// would discard and try to reread from the never written file header.
+static Int_t ReadFileKeys( TFile* file )
+{
+  if( file->InheritsFrom(TMemFile::Class()) ) {
+    TList* keys = file->GetListOfKeys();
+    return keys ? keys->GetSize() : 0;
+  }
+  return file->ReadKeys();
+}
+
 //_____________________________________________________________________________
 // Substitute placeholders in file name 'str'. Used to construct plot and image
 // file names
@@ -162,6 +198,9 @@ OnlineGUI::OnlineGUI()
   , fVerbosity{0}
   , fPrintOnly{false}
   , fSaveImages{false}
+  , fTakeSnapshot{false}
+  , fHistoryTime{0}
+  , fHistoryWindow{0}
 {
 }
 
@@ -177,6 +216,12 @@ OnlineGUI::OnlineGUI( OnlineConfig config )
   , fVerbosity{fConfig.GetVerbosity()}
   , fPrintOnly{fConfig.DoPrintOnly()}
   , fSaveImages{fConfig.DoSaveImages()}
+  , fTakeSnapshot{false}
+  , fHistoryTime{0}
+  , fHistoryWindow{0}
+  , fHistory{static_cast<size_t>(fConfig.GetHistoryBudget()) << 20}
+  , fTrend{fConfig.GetTrendFile()}
+  , fOverlays{64, [this]( Int_t run ) { return fConfig.FindRunFiles(run); }}
 {
   // Constructor. Make the GUI.
   int bin2Dx(0), bin2Dy(0);
@@ -189,10 +234,29 @@ OnlineGUI::OnlineGUI( OnlineConfig config )
     }
   }
 
+  if( fConfig.GetPadBudget() > 0 || fConfig.GetPageBudget() > 0 )
+    fBudget.reset(new DrawBudget(1e-3 * fConfig.GetPadBudget(),
+                                 1e-3 * fConfig.GetPageBudget()));
+
+  if( fConfig.GetThreads() > 1 ) {
+#ifdef R__USE_IMT
+    // Parallel basket decompression in TTree::Draw and friends
+    ROOT::EnableImplicitMT(fConfig.GetThreads());
+    if( fVerbosity >= 1 )
+      cout << "Using " << fConfig.GetThreads() << " threads" << endl;
+#else
+    cerr << "Warning: ROOT built without multithreading, ignoring threads "
+         << fConfig.GetThreads() << endl;
+#endif
+  }
+
+  if( fConfig.DoFixBinning() )
+    fBinning.reset(new BinningResolver(fConfig.GetBinningFile()));
+
   if( PrepareRootFiles() )
     throw runtime_error("Error opening ROOT file");
 
-  if( !fPrintOnly )
+  if( !fPrintOnly && !IsServer() )
     CreateGUI(gClient->GetRoot(), 1600, 1200);
 }
 
@@ -323,6 +387,43 @@ void OnlineGUI::CreateGUI( const TGWindow* p, UInt_t w, UInt_t h )
   fNext->Connect("Clicked()", "OnlineGUI", this, "DrawNext()");
   hframe->AddFrame(fNext, new TGLayoutHints(kLHintsCenterX, 5, 5, 1, 1));
 
+  if( fConfig.IsMonitor() ) {
+    // History controls: scroll back through snapshots taken at each update,
+    // or show only what changed in the last N minutes
+    fHistOlder = new TGTextButton(hframe, "<<");
+    fHistOlder->SetBackgroundColor(mainguicolor);
+    fHistOlder->SetToolTipText("Show previous snapshot");
+    fHistOlder->Connect("Clicked()", "OnlineGUI", this, "HistoryOlder()");
+    hframe->AddFrame(fHistOlder, new TGLayoutHints(kLHintsCenterX, 5, 1, 1, 1));
+
+    fHistLive = new TGTextButton(hframe, "Live");
+    fHistLive->SetBackgroundColor(mainguicolor);
+    fHistLive->SetToolTipText("Show current state");
+    fHistLive->Connect("Clicked()", "OnlineGUI", this, "HistoryLive()");
+    hframe->AddFrame(fHistLive, new TGLayoutHints(kLHintsCenterX, 1, 1, 1, 1));
+
+    fHistNewer = new TGTextButton(hframe, ">>");
+    fHistNewer->SetBackgroundColor(mainguicolor);
+    fHistNewer->SetToolTipText("Show next snapshot");
+    fHistNewer->Connect("Clicked()", "OnlineGUI", this, "HistoryNewer()");
+    hframe->AddFrame(fHistNewer, new TGLayoutHints(kLHintsCenterX, 1, 5, 1, 1));
+
+    auto* windowLabel = new TGLabel(hframe, "Last minutes:");
+    windowLabel->SetBackgroundColor(mainguicolor);
+    hframe->AddFrame(windowLabel, new TGLayoutHints(kLHintsCenterX | kLHintsCenterY, 5, 1, 1, 1));
+    fHistWindow = new TGNumberEntry(hframe, 0, 4, -1,
+                                    TGNumberFormat::kNESInteger,
+                                    TGNumberFormat::kNEANonNegative,
+                                    TGNumberFormat::kNELLimitMinMax, 0, 1440);
+    fHistWindow->Connect("ValueSet(Long_t)", "OnlineGUI", this,
+                         "HistoryWindow(Long_t)");
+    hframe->AddFrame(fHistWindow, new TGLayoutHints(kLHintsCenterX, 1, 5, 1, 1));
+
+    fHistLabel = new TGLabel(hframe, "Live");
+    fHistLabel->SetBackgroundColor(mainguicolor);
+    hframe->AddFrame(fHistLabel, new TGLayoutHints(kLHintsCenterX | kLHintsCenterY, 5, 5, 1, 1));
+  }
+
   fExit = new TGTextButton(hframe, "Exit GUI");
   fExit->SetBackgroundColor(red);
   fExit->Connect("Clicked()", "OnlineGUI", this, "CloseGUI()");
@@ -381,7 +482,8 @@ void OnlineGUI::CreateGUI( const TGWindow* p, UInt_t w, UInt_t h )
     } else {
       TTimer::Connect(timer, "Timeout()", "OnlineGUI", this, "CheckRootFile()");
     }
-    timer->Start(UPDATETIME);
+    timer->Start(fConfig.GetUpdateTime() > 0 ? fConfig.GetUpdateTime()
+                                             : UPDATETIME);
   }
 
 }
@@ -390,46 +492,18 @@ void OnlineGUI::DoDraw()
 {
   // The main Drawing Routine.
 
-  gStyle->SetOptStat(1110);
-  //gStyle->SetStatFontSize(0.1);
-  if( fConfig.IsLogy(current_page) ) {
-    gStyle->SetOptLogy(1);
-  } else {
-    gStyle->SetOptLogy(0);
-  }
-  //   gStyle->SetTitleH(0.10);
-  //   gStyle->SetTitleW(0.40);
-  gStyle->SetTitleH(0.1);
-  //  gStyle->SetTitleX(0.55);
-  //gStyle->SetTitleW(0.6);
-  //gStyle->SetTitleW(0.60);
-  //gStyle->SetStatH(0.2);
-  gStyle->SetStatW(0.25);
-  gStyle->SetStatX(0.9);
-  gStyle->SetStatY(0.88);
-  //   gStyle->SetLabelSize(0.10,"X");
-  //   gStyle->SetLabelSize(0.10,"Y");
-  gStyle->SetLabelSize(0.05, "X");
-  gStyle->SetLabelSize(0.05, "Y");
-  gStyle->SetPadLeftMargin(0.15);
-  gStyle->SetPadBottomMargin(0.08);
-  gStyle->SetPadRightMargin(0.1);
-  gStyle->SetPadTopMargin(0.12);
-  // gStyle->SetNdivisions(505,"X");
-  // gStyle->SetNdivisions(404,"Y");
-  // gROOT->ForceStyle();
-
-  TGaxis::SetMaxDigits(3);
-
-  gStyle->SetNdivisions(505, "XYZ");
-  gROOT->ForceStyle();
+  // Style of the page, computed once. Histograms read from files get it
+  // in HistDraw and while macros run, rather than restyling everything with
+  // gROOT->ForceStyle().
+  auto ist = fPageStyles.find(current_page);
+  if( ist == fPageStyles.end() )
+    ist = fPageStyles.emplace(current_page,
+      PageStyle(fConfig.IsLogy(current_page),
+                fConfig.GetDrawCount(current_page))).first;
+  fStyle = &ist->second;
+  fStyle->Use();
 
   // Determine the dimensions of the canvas..
-  UInt_t draw_count = fConfig.GetDrawCount(current_page);
-  if( draw_count >= 8 ) {
-    gStyle->SetLabelSize(0.08, "X");
-    gStyle->SetLabelSize(0.08, "Y");
-  }
   //   Int_t dim = Int_t(round(sqrt(double(draw_count))));
   Int_t nx, ny;
   std::tie(nx, ny) = fConfig.GetPageDim(current_page);
@@ -439,38 +513,22 @@ void OnlineGUI::DoDraw()
 
   // Create a nice clean canvas.
   fCanvas->Clear();
-  fCanvas->Divide(nx, ny);
-
-  cmdmap_t drawcommand;
-  //keys are "variable", "cut", "drawopt", "title", "treename", "grid", "nostat"
-
-  // Draw the histograms.
-  for( Int_t i = 0; i < SINT(draw_count); i++ ) {
-    current_pad = i + 1;
-    fConfig.GetDrawCommand(current_page, current_pad - 1, drawcommand);
-    fCanvas->cd(current_pad);
-
-    const string& cmd = getMapVal(drawcommand, "variable");
-    if( !cmd.empty() ) {
-      if( cmd == "macro" ) {
-        SaveMacroImage(drawcommand);
-        MacroDraw(drawcommand);
-      } else if( cmd == "loadmacro" ) {
-        LoadDraw(drawcommand);
-      } else if( cmd == "loadlib" ) {
-        LoadLib(drawcommand);
-      } else if( IsHistogram(cmd) ) {
-        HistDraw(drawcommand);
-      } else {
-        TreeDraw(drawcommand);
-      }
-    }
+  fDensePads.clear();
+  fProgressive.clear();
+  fNextProgressive = 0;
+  if( fLive && fLive->IsPageServer() ) {
+    // Thin client: the page has been drawn by the server
+    ServedPageDraw();
+  } else {
+    fCanvas->Divide(nx, ny);
+    DrawPads();
   }
+  fTakeSnapshot = kFALSE;
 
   fCanvas->cd();
   fCanvas->Update();
 
-  if( fConfig.IsMonitor() ) {
+  if( fConfig.IsMonitor() && !fPrintOnly && !IsServer() ) {
     char buffer[9]; // HH:MM:SS
     time_t t = time(nullptr);
     TString sLastUpdated("Plots updated at: ");
@@ -478,9 +536,7 @@ void OnlineGUI::DoDraw()
     sLastUpdated += buffer;
     fLastUpdated->SetText(sLastUpdated);
 
-    struct stat result{};
-    stat(fConfig.GetRootFile(), &result);
-    time_t tf = result.st_mtime;
+    time_t tf = GetRootFileTime();
     strftime(buffer, 9, "%T", localtime(&tf));
 
     TString sRootFileLastUpdated("File updated at: ");
@@ -499,12 +555,252 @@ void OnlineGUI::DoDraw()
     }
   }
 
-  if( !fPrintOnly ) {
+  if( !fPrintOnly && !IsServer() ) {
     CheckPageButtons();
   }
 
 }
 
+//_____________________________________________________________________________
+// Draw all pads of the current page
+void OnlineGUI::DrawPads()
+{
+  UInt_t draw_count = fConfig.GetDrawCount(current_page);
+  cmdmap_t drawcommand;
+  //keys are "variable", "cut", "drawopt", "title", "treename", "grid", "nostat"
+  time_t now = time(nullptr);
+  // Pads that are not recomputed show their cached contents. Only worth it
+  // when pages are drawn repeatedly.
+  bool repeated = !fPrintOnly;
+  Long64_t nowms = static_cast<Long64_t>(gSystem->Now());
+  if( fBudget )
+    fBudget->StartPage();
+  PreloadHistograms();
+  PrefillTreePads();
+
+  // Draw the histograms.
+  for( Int_t i = 0; i < SINT(draw_count); i++ ) {
+    current_pad = i + 1;
+    fConfig.GetDrawCommand(current_page, current_pad - 1, drawcommand);
+    fCanvas->cd(current_pad);
+
+    const string& cmd = getMapVal(drawcommand, "variable");
+    ostringstream ostr;
+    ostr << current_page << "/" << current_pad;
+    string key = ostr.str();
+    bool scheduled = repeated && (drawcommand.count("every") > 0 ||
+                                  drawcommand.count("refresh") > 0);
+    bool due = true;
+    bool partial = false;  // Plot drawn from a sample, still being refined
+    if( !cmd.empty() && scheduled ) {
+      long long interval = drawcommand.count("refresh") > 0 ?
+                           ParseInterval(drawcommand["refresh"]) : 0;
+      due = fSchedule.IsDue(key, atoi(getMapVal(drawcommand, "every").c_str()),
+                            max(interval, 0LL), nowms, fTakeSnapshot);
+    }
+    if( !cmd.empty() && !due && fPadCache.Has(key) ) {
+      fPadCache.Restore(key, fCanvas->GetPad(current_pad));
+      char buffer[9]; // HH:MM:SS
+      time_t tsaved = fPadCache.GetTime(key);
+      strftime(buffer, 9, "%T", localtime(&tsaved));
+      NotePad(string("as of ") + buffer, kGray + 2);
+    } else if( !cmd.empty() && repeated && fBudget && fPadCache.Has(key) &&
+               fBudget->Skip(current_page, current_pad) ) {
+      fPadCache.Restore(key, fCanvas->GetPad(current_pad));
+      NotePad("not updated: " + fBudget->GetStatus(current_page, current_pad),
+              kGray + 2);
+    } else if( !cmd.empty() ) {
+      if( fBudget )
+        fBudget->StartPad(current_page, current_pad);
+      if( cmd == "macro" ) {
+        SaveMacroImage(drawcommand);
+        MacroDraw(drawcommand);
+      } else if( cmd == "loadmacro" ) {
+        LoadDraw(drawcommand);
+      } else if( cmd == "loadlib" ) {
+        LoadLib(drawcommand);
+      } else if( cmd == "stripchart" ) {
+        StripChartDraw(drawcommand);
+      } else if( cmd == "trend" ) {
+        TrendDraw(drawcommand);
+      } else if( IsHistogram(cmd) ) {
+        HistDraw(drawcommand);
+      } else {
+        TreeDraw(drawcommand);
+      }
+      fCanvas->cd(current_pad);
+      // A plot drawn from a sample is recorded and cached only once it is
+      // complete (see ProgressiveStep)
+      auto job = find_if(fProgressive.begin(), fProgressive.end(),
+                         [&key]( const ProgressiveJob& j ) { return j.key == key; });
+      partial = (job != fProgressive.end());
+      if( partial ) {
+        job->snapshot = fTakeSnapshot && fConfig.IsMonitor();
+        job->cache = repeated && (fBudget || scheduled);
+      } else if( repeated && (fBudget || scheduled) ) {
+        fPadCache.Save(key, fCanvas->GetPad(current_pad));
+      }
+      if( fBudget ) {
+        bool over = fBudget->EndPad();
+        string status = fBudget->GetStatus(current_page, current_pad);
+        if( !status.empty() )
+          NotePad(status, over ? kRed : kGray + 2);
+      }
+    }
+    if( fConfig.IsMonitor() && !fPrintOnly && !IsServer() )
+      PadHistory(now, !partial);
+    if( fPrintOnly )
+      TrendRecord(drawcommand);
+  }
+  fPrefilled.clear();
+}
+
+//_____________________________________________________________________________
+// Read the histograms of the current page from the input file in parallel,
+// before its pads are drawn. The histograms are left in their directories
+// of fRootFile, where HistDraw() then finds them in memory. Pads that may
+// not be redrawn ("-every", "-refresh") are left out, as are in-memory
+// inputs (live sources, merged segments). Only done if more than one thread
+// was requested with --threads. The file handles of the threads are kept
+// across monitor updates until the input file is replaced.
+void OnlineGUI::PreloadHistograms()
+{
+#ifdef R__USE_IMT
+  if( !fRootFile || !fRootFile->IsOpen() || dynamic_cast<TMemFile*>(fRootFile) )
+    return;
+  if( fConfig.GetThreads() < 2 )
+    return;
+  // Directory of fRootFile and name of histogram 'path' ("dir/name")
+  auto split = [this]( const string& path, string& base ) -> TDirectory* {
+    size_t slash = path.rfind('/');
+    base = path.substr(slash == string::npos ? 0 : slash + 1);
+    return (slash == string::npos) ? fRootFile
+      : fRootFile->GetDirectory(path.substr(0, slash).c_str());
+  };
+  UInt_t draw_count = fConfig.GetDrawCount(current_page);
+  vector<string> names;
+  string base;
+  cmdmap_t command;
+  for( Int_t i = 0; i < SINT(draw_count); i++ ) {
+    fConfig.GetDrawCommand(current_page, i, command);
+    if( !fPrintOnly && (command.count("every") > 0 || command.count("refresh") > 0) )
+      continue;
+    const string& var = getMapVal(command, "variable");
+    if( var.empty() || find(names.begin(), names.end(), var) != names.end() )
+      continue;
+    for( const auto& fileObject: fileObjects ) {
+      if( fileObject.name == var && (fileObject.type.BeginsWith("TH1") ||
+                                     fileObject.type.BeginsWith("TH2") ||
+                                     fileObject.type.BeginsWith("TH3")) ) {
+        // Skip histograms already read
+        TDirectory* dir = split(var, base);
+        if( dir && !dir->GetList()->FindObject(base.c_str()) )
+          names.push_back(var);
+        break;
+      }
+    }
+  }
+  if( names.size() < 2 )
+    return;
+  if( !fPreloader || !fPreloader->IsFile(fRootFile->GetName()) ) {
+    auto nthreads = static_cast<unsigned>(fConfig.GetThreads());
+    fPreloader.reset(new ParallelReader(fRootFile->GetName(), nthreads));
+  }
+  auto objs = fPreloader->Read(names);
+  Int_t nread = 0;
+  for( size_t i = 0; i < names.size(); ++i ) {
+    auto* h = dynamic_cast<TH1*>(objs[i].get());
+    if( !h )
+      continue;
+    TDirectory* dir = split(names[i], base);
+    if( !dir )
+      continue;
+    h->SetDirectory(dir);  // Now owned by 'dir'
+    objs[i].release();
+    ++nread;
+  }
+  if( fVerbosity >= 2 )
+    cout << "Preloaded " << nread << " histograms on "
+         << fPreloader->GetNthreads() << " threads" << endl;
+#endif
+}
+
+//_____________________________________________________________________________
+// True if TTree::Draw with 'drawopt' would draw a plain histogram of 'var',
+// which SharedTreeFill or FastTreeFill can then fill instead
+static bool IsHistDraw( const TString& var, const TString& drawopt )
+{
+  TString opt = drawopt;
+  opt.ToLower();
+  for( const char* o: {"same", "prof", "goff", "para", "candle", "violin", "gl"} ) {
+    if( opt.Contains(o) )
+      return false;
+  }
+  if( !var.Contains(":") )
+    return true;
+  // Otherwise, 2D draws are scatter plots of the individual points
+  for( const char* o: {"col", "box", "lego", "surf", "cont", "text", "arr"} ) {
+    if( opt.Contains(o) )
+      return true;
+  }
+  return false;
+}
+
+//_____________________________________________________________________________
+// Fill the histograms of all plain 1D tree draws of the current page that
+// use the same tree in a single pass over that tree, evaluating identical
+// expressions and cuts only once. TreeDraw() then just draws the results.
+// Plots that are sampled, time-budgeted, scheduled or merged from segments
+// are drawn the usual way.
+void OnlineGUI::PrefillTreePads()
+{
+  fPrefilled.clear();
+  if( fSegments || fBudget || fBinning )
+    return;
+  UInt_t draw_count = fConfig.GetDrawCount(current_page);
+  map<UInt_t, vector<Int_t>> treepads;  // Tree index -> pads
+  cmdmap_t command;
+  for( Int_t i = 0; i < SINT(draw_count); i++ ) {
+    fConfig.GetDrawCommand(current_page, i, command);
+    const string& cmd = getMapVal(command, "variable");
+    if( cmd.empty() || cmd == "macro" || cmd == "loadmacro" ||
+        cmd == "loadlib" || cmd == "stripchart" || cmd == "trend" ||
+        IsHistogram(cmd) || command.count("sample") > 0 ||
+        command.count("every") > 0 || command.count("refresh") > 0 ||
+        !IsHistDraw(cmd.c_str(), getMapVal(command, "drawopt").c_str()) )
+      continue;
+    UInt_t iTree = FindTreeIndex(command, cmd);
+    if( iTree >= fRootTree.size() )
+      continue;
+    if( !fPrintOnly && !IsServer() && fConfig.GetProgressiveEntries() > 0 &&
+        fRootTree[iTree]->GetEntries() >= fConfig.GetProgressiveEntries() )
+      continue;
+    treepads[iTree].push_back(i + 1);
+  }
+  for( const auto& tp: treepads ) {
+    if( tp.second.size() < 2 )
+      continue;  // Nothing to share
+    SharedTreeFill shared(fRootTree[tp.first]);
+    map<Int_t, Int_t> index;  // Pad -> histogram
+    for( auto pad: tp.second ) {
+      fConfig.GetDrawCommand(current_page, pad - 1, command);
+      Int_t ih = shared.Add(getMapVal(command, "variable"),
+                            MakeCut(command).GetTitle());
+      if( ih >= 0 )
+        index[pad] = ih;
+    }
+    if( index.size() < 2 || shared.Run() < 0 )
+      continue;
+    if( fVerbosity >= 2 )
+      cout << "Filled " << index.size() << " pads from tree "
+           << fRootTree[tp.first]->GetName() << " in one pass" << endl;
+    for( const auto& pi: index ) {
+      Long64_t nsel = 0;
+      fPrefilled[pi.first] = shared.TakeHist(pi.second, nsel);
+    }
+  }
+}
+
 void OnlineGUI::DrawNext()
 {
   // Handler for the "Next" button.
@@ -618,7 +914,7 @@ void OnlineGUI::GetFileObjects()
   //    using h2root)
   //  If there's no good keys.. do nothing.
 
-  if( fRootFile->ReadKeys() == 0 ) {
+  if( ReadFileKeys(fRootFile) == 0 ) {
     fUpdate = kFALSE;
     //     delete fRootFile;
     //     fRootFile = 0;
@@ -675,9 +971,16 @@ void OnlineGUI::GetTreeVars()
 void OnlineGUI::GetRootTree()
 {
   // Utility to search a ROOT File for ROOT Trees
-  // Fills the fRootTree vector
+  // Fills the fRootTree vector. RNTuples are indexed in OpenInputFile.
   fRootTree.clear();
 
+  if( fSegments ) {
+    // Multi-file run: chains over all segments
+    fRootTree = fSegments->GetChains();
+    fTreeEntries.assign(fRootTree.size(), 0);
+    return;
+  }
+
   std::list<TString> found;
   for( const auto& fileObject: fileObjects ) {
 
@@ -750,6 +1053,45 @@ UInt_t OnlineGUI::GetTreeIndexFromName( const TString& name )
   return fRootTree.size() + 1;
 }
 
+//_____________________________________________________________________________
+// Determine which Tree the variable of a draw command comes from, either
+// from the "-tree" option or by searching for the variable name.
+UInt_t OnlineGUI::FindTreeIndex( const cmdmap_t& command, const TString& var )
+{
+  UInt_t iTree;
+  const string& mtree = getMapVal(command, "tree");
+  if( mtree.empty() ) {
+    iTree = GetTreeIndex(var);
+    if( fVerbosity >= 2 )
+      cout << "got index from variable " << iTree << endl;
+  } else {
+    iTree = GetTreeIndexFromName(mtree);
+    if( fVerbosity >= 2 )
+      cout << "got index from command " << iTree << endl;
+  }
+  return iTree;
+}
+
+//_____________________________________________________________________________
+// Combine the cuts of a draw command (definecuts and specific cuts)
+TCut OnlineGUI::MakeCut( const cmdmap_t& command )
+{
+  TCut cut = "";
+  const string& mcut = getMapVal(command, "cut");
+  if( command.size() > 1 ) {
+    TString tempCut = mcut;
+    vector<string> cutIdents = fConfig.GetCutIdent();
+    for( const auto& cutIdent: cutIdents ) {
+      if( tempCut.Contains(cutIdent) ) {
+        TString cut_found = fConfig.GetDefinedCut(cutIdent);
+        tempCut.ReplaceAll(cutIdent, cut_found);
+      }
+    }
+    cut = (TCut) tempCut;
+  }
+  return cut;
+}
+
 void OnlineGUI::MacroDraw( const cmdmap_t& command )
 {
   // Called by DoDraw(), this will make a call to the defined macro, and
@@ -764,7 +1106,10 @@ void OnlineGUI::MacroDraw( const cmdmap_t& command )
     gStyle->SetOptStat(0);
 
   if( doGolden ) fRootFile->cd();
-  gROOT->Macro(macro.c_str());
+  {
+    ForcedStyle forced;  // Histograms the macro reads get the page style
+    gROOT->Macro(macro.c_str());
+  }
   if( nostat )
     gStyle->SetOptStat(optstat);
 }
@@ -775,8 +1120,9 @@ void OnlineGUI::LoadDraw( const cmdmap_t& command )
   // and then make a call to the defined macro, and
   // plot it in its own pad.  One plot per macro, please.
 
-  //  TString slib("library");
-  //TString smacro("macro");
+  // The macro may be a draw function of a compiled plugin in the library
+  // (see panguinPlugins.hh), called directly, or else a macro command run
+  // by ROOT.
 
   const string& lib = getMapVal(command, "library");
   const string& mac = getMapVal(command, "macro");
@@ -786,10 +1132,22 @@ void OnlineGUI::LoadDraw( const cmdmap_t& command )
   }
 
   if( doGolden ) fRootFile->cd();
-  gSystem->Load(lib.c_str());
-  gROOT->Macro(mac.c_str());
-
-
+  if( !fLibraries.Load(lib) ) {
+    BadDraw(fLibraries.GetError(lib));
+    return;
+  }
+  ForcedStyle forced;  // Histograms the macro reads get the page style
+  string name, args;
+  PanguinDraw_t draw = SplitMacroCall(mac, name, args)
+                       ? fLibraries.FindDraw(lib, name) : nullptr;
+  if( draw ) {
+    draw(gPad, fRootFile, args.c_str());
+    return;
+  }
+  Int_t err = 0;
+  gROOT->Macro(mac.c_str(), &err);
+  if( err != 0 )
+    BadDraw("Cannot run " + mac);
 }
 
 void OnlineGUI::LoadLib( const cmdmap_t& command )
@@ -803,9 +1161,8 @@ void OnlineGUI::LoadLib( const cmdmap_t& command )
   }
 
   if( doGolden ) fRootFile->cd();
-  gSystem->Load(lib.c_str());
-
-
+  if( !fLibraries.Load(lib) )
+    BadDraw(fLibraries.GetError(lib));
 }
 
 void OnlineGUI::DoDrawClear()
@@ -825,21 +1182,23 @@ void OnlineGUI::TimerUpdate()
   if( fVerbosity >= 1 )
     cout << __PRETTY_FUNCTION__ << "\t" << __LINE__ << endl;
 
-#ifdef OLDTIMERUPDATE
+  if( fLive && fLive->IsPageServer() ) {
+    // Thin client: nothing to reload, just get the latest page
+    DoDraw();
+    timer->Reset();
+    return;
+  }
+
   if( fVerbosity >= 2 )
     cout << "\t rtFile: " << fRootFile << "\t" << fConfig.GetRootFile() << endl;
-  if( fRootFile ) {
-    fRootFile->Close();
-    fRootFile->Delete();
-    delete fRootFile;
-    fRootFile = nullptr;
-  }
-  fRootFile = new TFile(fConfig.GetRootFile(), "READ");
-  if( fRootFile->IsZombie() ) {
+  // Reopen the input, which picks up a new run, new segments or the latest
+  // histograms from the live source, then check that it has any keys
+  CloseInputFile();
+  fRootFile = OpenInputFile();
+  if( fRootFile->IsZombie() || (fRootFile->GetSize() == -1)
+      || (ReadFileKeys(fRootFile) == 0) ) {
     cout << "New run not yet available.  Waiting..." << endl;
-    fRootFile->Close();
-    delete fRootFile;
-    fRootFile = nullptr;
+    CloseInputFile();
     timer->Reset();
     timer->Disconnect();
     TTimer::Connect(timer, "Timeout()", "OnlineGUI", this, "CheckRootFile()");
@@ -857,39 +1216,16 @@ void OnlineGUI::TimerUpdate()
 
   // Open the Root Trees.  Give a warning if it's not there.
   GetFileObjects();
-  if( fUpdate ) { // Only do this stuff if there are valid keys
-    GetRootTree();
-    GetTreeVars();
-    for( UInt_t i = 0; i < fRootTree.size(); i++ ) {
-      if( !fRootTree[i] ) {
-        fRootTree.erase(fRootTree.begin() + i);
-      }
+  GetRootTree();
+  GetTreeVars();
+  for( UInt_t i = 0; i < fRootTree.size(); i++ ) {
+    if( !fRootTree[i] ) {
+      fRootTree.erase(fRootTree.begin() + i);
     }
-    DoDraw();
-  }
-  timer->Reset();
-
-#else
-
-  if(fRootFile->IsZombie() || (fRootFile->GetSize() == -1)
-     || (fRootFile->ReadKeys()==0)) {
-    cout << "New run not yet available.  Waiting..." << endl;
-    fRootFile->Close();
-    delete fRootFile;
-    fRootFile = 0;
-    timer->Reset();
-    timer->Disconnect();
-    timer->Connect(timer,"Timeout()","OnlineGUI",this,"CheckRootFile()");
-    return;
-  }
-  for(UInt_t i=0; i<fRootTree.size(); i++) {
-    fRootTree[i]->Refresh();
   }
+  fTakeSnapshot = kTRUE;
   DoDraw();
   timer->Reset();
-
-#endif
-
 }
 
 void OnlineGUI::UpdateCurrentTime()
@@ -903,6 +1239,130 @@ void OnlineGUI::UpdateCurrentTime()
   timerNow->Reset();
 }
 
+//_____________________________________________________________________________
+// Record a snapshot of the histogram in the current pad, if requested by
+// TimerUpdate() and 'record' is set. If a past state or only recent changes are to be shown
+// (history controls), replace the histogram in the pad with the state
+// reconstructed from the history.
+void OnlineGUI::PadHistory( time_t now, bool record )
+{
+  TH1* hist = nullptr;
+  TObjLink* link = nullptr;
+  for( auto* lnk = gPad->GetListOfPrimitives()->FirstLink(); lnk;
+       lnk = lnk->Next() ) {
+    if( auto* h = dynamic_cast<TH1*>(lnk->GetObject()) ) {
+      hist = h;   // Last one drawn is the current one (golden is drawn first)
+      link = lnk;
+    }
+  }
+  if( !hist )
+    return;
+
+  ostringstream ostr;
+  ostr << current_page << "/" << current_pad;
+  string key = ostr.str();
+  if( fTakeSnapshot && record )
+    fHistory.Record(key, hist, now);
+  if( fHistoryTime == 0 && fHistoryWindow == 0 )
+    return;
+
+  vector<double> contents, past;
+  double entries = 0, past_entries = 0;
+  time_t tshow = fHistory.GetContents(
+    key, fHistoryTime != 0 ? fHistoryTime : now, contents, entries);
+  if( tshow == 0 || SINT(contents.size()) != hist->GetNcells() )
+    return;
+  TString title = hist->GetTitle();
+  if( fHistoryWindow > 0 ) {
+    time_t tpast = fHistory.GetContents(key, tshow - 60 * fHistoryWindow,
+                                        past, past_entries);
+    for( size_t i = 0; i < contents.size(); ++i )
+      contents[i] -= past[i];
+    entries -= past_entries;
+    title += Form(" [last %ld s]", static_cast<long>(tshow - tpast));
+  }
+  if( fHistoryTime != 0 ) {
+    char buffer[9]; // HH:MM:SS
+    strftime(buffer, 9, "%T", localtime(&tshow));
+    title += " [";
+    title += buffer;
+    title += "]";
+  }
+  auto& past_hist = fHistoryHists[key];
+  past_hist.reset(static_cast<TH1*>(hist->Clone(TString(hist->GetName()) + "_hist")));
+  past_hist->SetDirectory(nullptr);
+  past_hist->Sumw2(kFALSE);
+  past_hist->SetContent(contents.data());
+  past_hist->ResetStats();
+  past_hist->SetEntries(entries);
+  past_hist->SetTitle(title);
+  link->SetObject(past_hist.get());
+}
+
+//_____________________________________________________________________________
+void OnlineGUI::UpdateHistoryLabel()
+{
+  TString label;
+  if( fHistoryTime == 0 ) {
+    label = "Live";
+  } else {
+    char buffer[9]; // HH:MM:SS
+    strftime(buffer, 9, "%T", localtime(&fHistoryTime));
+    label = buffer;
+  }
+  if( fHistoryWindow > 0 )
+    label += Form(", last %d min", fHistoryWindow);
+  fHistLabel->SetText(label);
+  hframe->Layout();
+}
+
+//_____________________________________________________________________________
+// Handler for the history "<<" button: step back one snapshot
+void OnlineGUI::HistoryOlder()
+{
+  time_t from = fHistoryTime;
+  if( from == 0 )
+    from = fHistory.GetOlder(time(nullptr) + 1);  // Newest snapshot
+  time_t t = fHistory.GetOlder(from);
+  if( t == 0 )
+    return;
+  fHistoryTime = t;
+  UpdateHistoryLabel();
+  DoDraw();
+}
+
+//_____________________________________________________________________________
+// Handler for the history ">>" button: step forward one snapshot
+void OnlineGUI::HistoryNewer()
+{
+  if( fHistoryTime == 0 )
+    return;
+  time_t t = fHistory.GetNewer(fHistoryTime);
+  if( t == 0 || fHistory.GetNewer(t) == 0 )
+    t = 0;  // Reached the newest snapshot
+  fHistoryTime = t;
+  UpdateHistoryLabel();
+  DoDraw();
+}
+
+//_____________________________________________________________________________
+// Handler for the history "Live" button
+void OnlineGUI::HistoryLive()
+{
+  fHistoryTime = 0;
+  UpdateHistoryLabel();
+  DoDraw();
+}
+
+//_____________________________________________________________________________
+// Handler for the "Last minutes" entry. 0 shows the full accumulated state.
+void OnlineGUI::HistoryWindow( Long_t )
+{
+  fHistoryWindow = static_cast<Int_t>(fHistWindow->GetIntNumber());
+  UpdateHistoryLabel();
+  DoDraw();
+}
+
 void OnlineGUI::BadDraw( const TString& errMessage )
 {
   // Routine to display (in Pad) why a particular draw method has
@@ -926,7 +1386,11 @@ void OnlineGUI::CheckRootFile()
   //   Reopen new root file,
   //   Reconnect the timer to TimerUpdate()
 
-  if( gSystem->AccessPathName(fConfig.GetRootFile()) == 0 ) {
+  bool found = fConfig.IsLive() ||
+               (fConfig.IsMultiFile()
+                ? !fConfig.GetRootFiles().empty()
+                : gSystem->AccessPathName(fConfig.GetRootFile()) == 0);
+  if( found ) {
     cout << "Found the new run" << endl;
 #ifndef OLDTIMERUPDATE
     if(OpenRootFile()==0) {
@@ -949,22 +1413,26 @@ Int_t OnlineGUI::PrepareRootFiles()
   // Open the RootFile. Die if it doesn't exist unless we're watching a file.
   // Also open GoldenFile. Warn if it doesn't exist.
 
-  delete fRootFile; fRootFile = nullptr;
+  CloseInputFile();
   delete fGoldenFile; fGoldenFile = nullptr;
+  fGoldenCompare.clear();
+  fDisplayRebin.clear();
+  fPadCache.Clear();
+  fFrozenHists.clear();
+  fNtuples.Clear();  // New run: rescan
 
-  fRootFile = new TFile(fConfig.GetRootFile(), "READ");
+  fRootFile = OpenInputFile();
   if( !fRootFile->IsOpen() ) {
     ostringstream ostr;
     ostr << "ERROR:  rootfile: " << fConfig.GetRootFile()
          << " cannot be opened";
     fFileAlive = kFALSE;
-    if( !fPrintOnly && fConfig.IsMonitor() ) {
+    if( !fPrintOnly && (fConfig.IsMonitor() || IsServer()) ) {
       cout << ostr.str() << endl;
       cout << "Will wait... hopefully.." << endl;
     } else {
       cerr << ostr.str() << endl;
-      delete fRootFile;
-      fRootFile = nullptr;
+      CloseInputFile();
       return 1;
     }
   } else {
@@ -1000,15 +1468,103 @@ Int_t OnlineGUI::PrepareRootFiles()
   return 0;
 }
 
-Int_t OnlineGUI::OpenRootFile()
+//_____________________________________________________________________________
+// Open the ROOT file of the run. If the file name is a wildcard pattern, or
+// a list of files to merge was given, merge the referenced histograms of all
+// the files into an in-memory file and chain their trees.
+TFile* OnlineGUI::OpenInputFile()
 {
-  fRootFile = new TFile(fConfig.GetRootFile(), "READ");
-  if( fRootFile->IsZombie() || (fRootFile->GetSize() == -1)
-      || (fRootFile->ReadKeys() == 0) ) {
-    cout << "New run not yet available.  Waiting..." << endl;
+  // Compiled expressions are rebound to the trees of the new file
+  fFormulas.NewFile();
+  // Index the RNTuples of the input, once per set of files
+  fNtuples.Scan(fConfig.GetRootFiles());
+  if( fConfig.IsLive() ) {
+    // Histograms published by a running analyzer
+    if( !fLive ) {
+      fLive.reset(new LiveSource(fConfig.GetLiveSource()));
+      fLive->SetSelection(fConfig.GetReferencedObjects());
+    }
+    TFile* file = fLive->Open();
+    if( !file )  // Publisher not (yet) available
+      file = new TMemFile("panguin_live.root", "RECREATE", "", 0);
+    return file;
+  }
+  if( !fConfig.IsMultiFile() ) {
+    fSegments.reset();
+    return new TFile(fConfig.GetRootFile(), "READ");
+  }
+  if( !fSegments ) {
+    fSegments.reset(new SegmentedRun(fConfig.GetThreads()));
+    fSegments->SetSelection(fConfig.GetMergeSelection());
+  }
+  auto files = fConfig.GetRootFiles();
+  if( fVerbosity >= 1 )
+    cout << "Merging " << files.size() << " files using "
+         << fSegments->GetNthreads() << " threads" << endl;
+  TFile* file = fSegments->Open(files);
+  if( !file )  // No segments yet. Get a zombie, like for a missing file
+    file = new TFile(fConfig.GetRootFile(), "READ");
+  return file;
+}
+
+//_____________________________________________________________________________
+// Modification time of the ROOT file, or of the newest segment, or time of
+// the last update from the live source
+time_t OnlineGUI::GetRootFileTime() const
+{
+  if( fLive )
+    return fLive->GetUpdateTime();
+  time_t tf = 0;
+  for( const auto& file: fConfig.GetRootFiles() ) {
+    struct stat result{};
+    if( stat(file.c_str(), &result) == 0 && result.st_mtime > tf )
+      tf = result.st_mtime;
+  }
+  return tf;
+}
+
+//_____________________________________________________________________________
+// Close and delete the input file. The fills of sampled plots still in
+// progress read its trees, so they are stopped first.
+void OnlineGUI::CloseInputFile()
+{
+  if( fProgressTimer )
+    fProgressTimer->Stop();
+  fProgressive.clear();
+  fNextProgressive = 0;
+  if( fRootFile ) {
     fRootFile->Close();
     delete fRootFile;
     fRootFile = nullptr;
+  }
+}
+
+//_____________________________________________________________________________
+// Reopen the input for the next update of the page server. Returns false
+// if no data are available.
+Bool_t OnlineGUI::ReopenInput()
+{
+  CloseInputFile();
+  fRootFile = OpenInputFile();
+  if( fRootFile->IsZombie() || (fRootFile->GetSize() == -1)
+      || (ReadFileKeys(fRootFile) == 0) ) {
+    CloseInputFile();
+    return false;
+  }
+  runNumber = fConfig.GetRunNumber();
+  GetFileObjects();
+  GetRootTree();
+  GetTreeVars();
+  return true;
+}
+
+Int_t OnlineGUI::OpenRootFile()
+{
+  fRootFile = OpenInputFile();
+  if( fRootFile->IsZombie() || (fRootFile->GetSize() == -1)
+      || (ReadFileKeys(fRootFile) == 0) ) {
+    cout << "New run not yet available.  Waiting..." << endl;
+    CloseInputFile();
     timer->Reset();
     timer->Disconnect();
     TTimer::Connect(timer, "Timeout()", "OnlineGUI", this, "CheckRootFile()");
@@ -1102,13 +1658,19 @@ void OnlineGUI::HistDraw( const cmdmap_t& command )
         if( showGolden ) fRootFile->cd();
         mytemp1d = dynamic_cast<TH1*> (gDirectory->Get(cvar));
         if( !mytemp1d ) break;
+        fStyle->Apply(mytemp1d);
         if( mytemp1d->GetEntries() == 0 ) {
           BadDraw("Empty Histogram");
         } else {
-          if( showGolden ) {
+          if( command.find("overlay") != command.end() ) {
+            mytemp1d->SetStats(showstat);
+            if( newtitle != "" ) mytemp1d->SetTitle(newtitle);
+            OverlayDraw(mytemp1d, command);
+          } else if( showGolden ) {
             fGoldenFile->cd();
             mytemp1d_golden = dynamic_cast<TH1*> (gDirectory->Get(cvar));
             if( mytemp1d_golden ) {
+              fStyle->Apply(mytemp1d_golden);
               mytemp1d_golden->SetLineColor(30);
               mytemp1d_golden->SetFillColor(30);
               Style_t fillstyle = fPrintOnly ? 3010 : 3027;
@@ -1137,26 +1699,26 @@ void OnlineGUI::HistDraw( const cmdmap_t& command )
         if( showGolden ) fRootFile->cd();
         mytemp2d = dynamic_cast<TH2*> (gDirectory->Get(cvar));
         if( !mytemp2d ) break;
+        fStyle->Apply(mytemp2d);
         if( mytemp2d->GetEntries() == 0 ) {
           BadDraw("Empty Histogram");
         } else {
-          // These are commented out because it usually doesn't make sense to
-          // superimpose two 2d histos together
-          // 	  if(showGolden) {
-          // 	    fGoldenFile->cd();
-          // 	    mytemp2d_golden = (TH2*)gDirectory->Get(cvar);
-          // 	    mytemp2d_golden->SetMarkerColor(2);
-          // 	    mytemp2d_golden->Draw();
-          //mytemp2d->Draw("sames");
-          // 	  } else {
-//          if( drawopt.Contains("colz") ) {
-//            gPad->SetRightMargin(0.15);
-//          }
-
+          // It usually doesn't make sense to superimpose two 2d histos
+          // together. Instead, draw a bin-wise comparison map if requested.
           if( newtitle != "" ) mytemp2d->SetTitle(newtitle);
           mytemp2d->SetStats(showstat);
-          mytemp2d->Draw(drawopt);
-          SaveImage(mytemp2d, command);
+          if( !(showGolden && GoldenCompareDraw(mytemp2d, command)) ) {
+            // Draw huge histograms at the resolution of the pad
+            ostringstream ostr;
+            ostr << current_page << "/" << current_pad;
+            auto npx = static_cast<Int_t>(gPad->GetWw() * gPad->GetAbsWNDC());
+            auto npy = static_cast<Int_t>(gPad->GetWh() * gPad->GetAbsHNDC());
+            TH2* hdraw = fDisplayRebin[ostr.str()].Get(mytemp2d, npx, npy);
+            if( hdraw != mytemp2d )
+              fStyle->Apply(hdraw);
+            hdraw->Draw(drawopt);
+            SaveImage(hdraw, command);
+          }
           found = true;
         }
         break;
@@ -1165,14 +1727,18 @@ void OnlineGUI::HistDraw( const cmdmap_t& command )
         if( showGolden ) fRootFile->cd();
         mytemp3d = dynamic_cast<TH3*> (gDirectory->Get(cvar));
         if( !mytemp3d ) break;
+        fStyle->Apply(mytemp3d);
         if( mytemp3d->GetEntries() == 0 ) {
           BadDraw("Empty Histogram");
+        } else if( showGolden && GoldenCompareDraw(mytemp3d, command) ) {
+          found = true;
         } else {
           mytemp3d->Draw();
           if( showGolden ) {
             fGoldenFile->cd();
             mytemp3d_golden = dynamic_cast<TH3*> (gDirectory->Get(cvar));
             if( mytemp3d_golden ) {
+              fStyle->Apply(mytemp3d_golden);
               mytemp3d_golden->SetMarkerColor(2);
               mytemp3d_golden->Draw();
               mytemp3d->Draw("sames" + drawopt);
@@ -1193,6 +1759,144 @@ void OnlineGUI::HistDraw( const cmdmap_t& command )
     BadDraw( var + " not found");
 }
 
+//_____________________________________________________________________________
+// Draw a bin-wise comparison map (ratio, difference or pull) of 'hist' with
+// the corresponding histogram in the golden file, if requested with the
+// "-golden" option. Golden bin arrays and the result are cached per plot.
+// Returns false if nothing was drawn.
+Bool_t OnlineGUI::GoldenCompareDraw( TH1* hist, const cmdmap_t& command )
+{
+  const string& smode = getMapVal(command, "golden");
+  if( smode.empty() || !fGoldenFile )
+    return kFALSE;
+  ECompareMode mode = ParseCompareMode(smode);
+  if( mode == ECompareMode::kNone ) {
+    cerr << "Warning: unknown golden comparison \"" << smode << "\", "
+         << "expect ratio, diff or pull" << endl;
+    return kFALSE;
+  }
+  const string& var = getMapVal(command, "variable");
+  auto* golden = fGoldenFile->Get<TH1>(var.c_str());
+  if( !golden ) {
+    if( fVerbosity >= 1 )
+      cout << "No golden histogram for " << var << endl;
+    return kFALSE;
+  }
+  fStyle->Apply(golden);
+  TH1* cmp = fGoldenCompare[var + ":" + smode].Compare(hist, golden, mode);
+  if( !cmp ) {
+    BadDraw("Golden histogram binning differs");
+    return kTRUE;
+  }
+  fStyle->Apply(cmp);
+  TString drawopt = getMapVal(command, "drawopt");
+  if( drawopt.IsNull() && cmp->GetDimension() == 2 ) {
+    drawopt = "colz";
+    gPad->SetRightMargin(0.15);
+  }
+  cmp->SetStats(kFALSE);
+  cmp->Draw(drawopt);
+  SaveImage(cmp, command);
+  return kTRUE;
+}
+
+//_____________________________________________________________________________
+// Draw 1D histogram 'hist' of the current run together with the same
+// histogram of earlier runs, as requested with the "-overlay" option:
+// "last:N" for the N most recent earlier runs, or a comma-separated list of
+// run numbers. The earlier runs are scaled to the integral of the current
+// one. Their histograms are cached, so that only the current run is read
+// on each update.
+void OnlineGUI::OverlayDraw( TH1* hist, const cmdmap_t& command )
+{
+  static const Color_t colors[] = {kRed + 1, kBlue + 1, kMagenta + 1,
+                                   kOrange + 7, kCyan + 2, kViolet + 1};
+  const string& spec = getMapVal(command, "overlay");
+  vector<Int_t> runs;
+  if( spec.compare(0, 5, "last:") == 0 ) {
+    auto n = atoi(spec.c_str() + 5);
+    if( runNumber == 0 )
+      cerr << "Warning: run number unknown, cannot overlay " << spec << endl;
+    else if( n > 0 )
+      runs = fOverlays.FindPrevious(runNumber, n);
+  } else {
+    istringstream istr(spec);
+    string srun;
+    while( getline(istr, srun, ',') ) {
+      auto run = atoi(srun.c_str());
+      if( run > 0 && run != runNumber )
+        runs.push_back(run);
+    }
+  }
+  const string& var = getMapVal(command, "variable");
+  Double_t integral = hist->Integral();
+  Double_t ymax = hist->GetMaximum();
+  vector<TH1*> overlays;
+  vector<Int_t> overlay_runs;
+  for( auto run: runs ) {
+    TH1* past = fOverlays.Get(run, var);
+    if( !past || past->GetNbinsX() != hist->GetNbinsX() )
+      continue;
+    TH1* h = nullptr;
+    {
+      TDirectory::TContext ctx(nullptr);
+      h = static_cast<TH1*>(past->Clone(Form("%s_run%d", past->GetName(), run)));
+    }
+    Double_t pastint = h->Integral();
+    if( integral > 0 && pastint > 0 )
+      h->Scale(integral / pastint);
+    fStyle->Apply(h);
+    h->SetLineColor(colors[overlays.size() % (sizeof(colors) / sizeof(colors[0]))]);
+    h->SetFillStyle(0);
+    h->SetStats(false);
+    h->SetBit(TObject::kCanDelete);
+    ymax = max(ymax, h->GetMaximum());
+    overlays.push_back(h);
+    overlay_runs.push_back(run);
+  }
+
+  TString drawopt = getMapVal(command, "drawopt");
+  if( overlays.empty() ) {
+    hist->Draw(drawopt);
+    return;
+  }
+  // The first overlay sets up the frame, like the golden histogram
+  TH1* frame = overlays.front();
+  frame->SetMaximum(gPad->GetLogy() ? 2 * ymax : 1.05 * ymax);
+  frame->SetTitle(hist->GetTitle());
+  frame->Draw("hist");
+  for( auto* h: overlays ) {
+    if( h != frame )
+      h->Draw("hist same");
+  }
+  hist->Draw("sames" + drawopt);
+
+  auto* leg = new TLegend(0.16, 0.86 - 0.05 * (overlays.size() + 1), 0.4, 0.86);
+  leg->SetBorderSize(0);
+  leg->SetFillStyle(0);
+  leg->AddEntry(hist, runNumber != 0 ? Form("Run %d", runNumber) : "Current",
+                "l");
+  for( size_t i = 0; i < overlays.size(); ++i )
+    leg->AddEntry(overlays[i], Form("Run %d", overlay_runs[i]), "l");
+  leg->SetBit(TObject::kCanDelete);
+  leg->Draw();
+}
+
+// Trees with fewer entries are drawn in one go, even with a time budget
+static const Long64_t kMinBudgetEntries = 100000;
+
+//_____________________________________________________________________________
+// Name of the histogram of a tree draw with a plot title
+static TString TreeHistName( const TString& var, const TCut& cut,
+                             const TString& drawopt, const string& title )
+{
+  TString tmpstring(var);
+  tmpstring += cut.GetTitle();
+  tmpstring += drawopt;
+  tmpstring += title;
+  return tmpstring.MD5();
+}
+
 void OnlineGUI::TreeDraw( const cmdmap_t& command )
 {
   // Called by DoDraw(), this will plot a Tree Variable
@@ -1213,32 +1917,12 @@ void OnlineGUI::TreeDraw( const cmdmap_t& command )
   }
 
   // Combine the cuts (definecuts and specific cuts)
-  TCut cut = "";
   const string& mcut = getMapVal(command, "cut");
-  if( command.size() > 1 ) {
-    TString tempCut = mcut;
-    vector<string> cutIdents = fConfig.GetCutIdent();
-    for( const auto& cutIdent: cutIdents ) {
-      if( tempCut.Contains(cutIdent) ) {
-        TString cut_found = fConfig.GetDefinedCut(cutIdent);
-        tempCut.ReplaceAll(cutIdent, cut_found);
-      }
-    }
-    cut = (TCut) tempCut;
-  }
+  TCut cut = MakeCut(command);
 
   // Determine which Tree the variable comes from, then draw it.
-  UInt_t iTree;
   const string& mtree = getMapVal(command, "tree");
-  if( mtree.empty() ) {
-    iTree = GetTreeIndex(var);
-    if( fVerbosity >= 2 )
-      cout << "got index from variable " << iTree << endl;
-  } else {
-    iTree = GetTreeIndexFromName(mtree);
-    if( fVerbosity >= 2 )
-      cout << "got index from command " << iTree << endl;
-  }
+  UInt_t iTree = FindTreeIndex(command, var);
 
   const string& mopt = getMapVal(command, "drawopt");
   if( mopt.find("colz") != string::npos )
@@ -1267,16 +1951,106 @@ void OnlineGUI::TreeDraw( const cmdmap_t& command )
       gStyle->SetOptStat(0);
     else if( var.Contains(":") && drawopt.IsNull() )
       drawopt = " ";
-    Long64_t nentries = fRootTree[iTree]->Draw(var, cut, drawopt);
+    // Multi-file runs: fill histograms from all segments in parallel
+    Long64_t nentries = 0;
+    unique_ptr<TH1> hseg;
+    unique_ptr<ProgressiveFill> sampler;
+    if( fSegments )
+      hseg = fSegments->Draw(fRootTree[iTree], var, cut, drawopt, nentries);
+    auto prefilled = fPrefilled.find(current_pad);
+    if( prefilled != fPrefilled.end() ) {
+      hseg = std::move(prefilled->second);
+      fPrefilled.erase(prefilled);
+      nentries = static_cast<Long64_t>(hseg->GetEntries());
+    }
+    if( hseg ) {
+      if( nostat )
+        hseg->SetStats(false);
+      hseg->SetBit(TObject::kCanDelete);
+      hseg->Draw(drawopt);
+    } else if( nentries == 0 ) {
+      // Large trees: draw a sample first, then refine it in the GUI
+      Double_t fraction = 1;
+      const string& msample = getMapVal(command, "sample");
+      if( !msample.empty() )
+        fraction = (msample == "default") ? fConfig.GetSampleFraction()
+                                          : atof(msample.c_str());
+      else if( !fPrintOnly && !IsServer() && fConfig.GetProgressiveEntries() > 0 &&
+               fRootTree[iTree]->GetEntries() >= fConfig.GetProgressiveEntries() )
+        fraction = fConfig.GetSampleFraction();
+      // With a time budget, fill large trees in blocks that can be stopped
+      Double_t maxtime = 0;
+      if( fBudget ) {
+        fraction = min(fraction, fBudget->GetFraction(current_page, current_pad));
+        if( fRootTree[iTree]->GetEntries() >= kMinBudgetEntries )
+          maxtime = fBudget->GetTimeLeft();
+      }
+      if( (fraction < 1 || maxtime > 0) && !var.Contains(">>") ) {
+        sampler.reset(new ProgressiveFill(fRootTree[iTree], var, cut, fraction,
+                                          &fFormulas));
+        TString hname = Form("hsample_%d_%d", current_page, current_pad);
+        nentries = sampler->DrawSample(hname, drawopt, maxtime);
+        if( sampler->GetHist() )
+          histoname = hname;
+        else
+          sampler.reset();
+      } else {
+        if( fBinning )
+          hseg = FrozenDraw(command, iTree, var, cut, drawopt, nentries);
+        // Plain branches: fill the histogram directly, without TTreeFormula
+        if( !hseg && FastTreeFill::IsSimple(var, cut.GetTitle()) &&
+            IsHistDraw(var, drawopt) ) {
+          FastTreeFill fast(fRootTree[iTree], var, cut.GetTitle());
+          if( fast.IsValid() ) {
+            hseg.reset(FastTreeFill::Book("hfast", fRootTree[iTree], var, cut.GetTitle()));
+            nentries = fast.Fill(hseg.get(), 0, fRootTree[iTree]->GetEntries());
+            if( nentries < 0 ) {
+              hseg.reset();
+              nentries = 0;
+            }
+          }
+        }
+        // Other histograms: fill from the compiled expression, which is
+        // kept across updates, rather than have TTree::Draw parse it again
+        if( !hseg && !var.Contains(">>") && IsHistDraw(var, drawopt) ) {
+          TreeExpr* expr = fFormulas.Get(fRootTree[iTree], var, cut.GetTitle());
+          if( expr && expr->GetDimension() <= 2 ) {
+            hseg.reset(BookTreeHist("htemp", fRootTree[iTree], var, cut.GetTitle()));
+            nentries = expr->Fill(hseg.get(), 0, fRootTree[iTree]->GetEntries());
+            if( nentries < 0 ) {
+              hseg.reset();
+              nentries = 0;
+            }
+          }
+        }
+        if( hseg ) {
+          if( nostat )
+            hseg->SetStats(false);
+          hseg->SetBit(TObject::kCanDelete);
+          hseg->Draw(drawopt);
+        } else {
+          nentries = fRootTree[iTree]->Draw(var, cut, drawopt);
+        }
+      }
+      if( fBudget ) {
+        if( sampler )
+          fBudget->SetTreeDrawn(sampler->GetFraction(),
+                                sampler->GetFraction() < fraction);
+        else
+          fBudget->SetTreeDrawn(1, false);
+      }
+    }
     if( getMapVal(command, "grid") == "grid" ) {
       gPad->SetGrid();
     }
     if( nostat )
       gStyle->SetOptStat(optstat);
 
-    TObject* hobj = gROOT->FindObject(histoname);
+    TObject* hobj = hseg ? hseg.release() : gROOT->FindObject(histoname);
     if( fVerbosity >= 3 )
       cout << "Finished drawing with return value " << nentries << endl;
+    if( nentries > 0 )
+      DecimatePad(command);
 
     if( nentries == -1 ) {
       BadDraw(var + " not found");
@@ -1287,30 +2061,440 @@ void OnlineGUI::TreeDraw( const cmdmap_t& command )
         //  Makes it less likely to cause a name collision if two plot titles are the same.
         //  If you draw the exact same plot twice, the histograms will have the same name, but
         //  since they are exactly the same, you likely won't notice (or it will complain at you).
-        TString tmpstring(var);
-        tmpstring += cut.GetTitle();
-        tmpstring += drawopt;
-        tmpstring += mtitle;
-        TString myMD5 = tmpstring.MD5();
+        TString myMD5 = TreeHistName(var, cut, drawopt, mtitle);
         TH1* thathist = (TH1*) hobj;
         thathist->SetNameTitle(myMD5, mtitle.c_str());
+        if( sampler )
+          sampler->UpdateTitle();
         SaveImage(thathist, command);
       }
+      if( sampler && !sampler->IsDone() && !fPrintOnly && !IsServer() ) {
+        ostringstream ostr;
+        ostr << current_page << "/" << current_pad;
+        fProgressive.emplace_back();
+        fProgressive.back().fill = std::move(sampler);
+        fProgressive.back().key = ostr.str();
+        if( !fProgressTimer ) {
+          fProgressTimer = new TTimer();
+          TTimer::Connect(fProgressTimer, "Timeout()", "OnlineGUI", this,
+                          "ProgressiveStep()");
+        }
+        fProgressTimer->Start(10);
+      }
     } else {
       BadDraw("Empty Histogram");
     }
+  } else if( fNtuples.FindIndex(var, mtree) >= 0 ) {
+    NtupleDraw(command, fNtuples.FindIndex(var, mtree));
   } else {
     BadDraw(var + " not found");
     if( fConfig.IsMonitor() ) {
       // Maybe we missed it... look again.  I don't like the code
       // below... maybe I can come up with something better
       GetFileObjects();
+      fNtuples.Clear();
+      fNtuples.Scan(fConfig.GetRootFiles());
       GetRootTree();
       GetTreeVars();
     }
   }
 }
 
+//_____________________________________________________________________________
+// With "fixbinning": fill 'var' into a histogram with frozen binning. The
+// histogram of each pad is kept, so that later updates only need to fill
+// the tree entries added since. Returns a copy to draw, or nullptr if the
+// plot is to be drawn the usual way, e.g. when the binning cannot be
+// resolved yet for lack of entries.
+unique_ptr<TH1> OnlineGUI::FrozenDraw( const cmdmap_t& command, UInt_t iTree,
+                                       const TString& var, const TCut& cut,
+                                       const TString& drawopt, Long64_t& nentries )
+{
+  TTree* tree = fRootTree[iTree];
+  if( var.Contains(">>") || !IsHistDraw(var, drawopt) )
+    return nullptr;
+  TString cutstr = cut.GetTitle();
+  string key = string(tree->GetName()) + " " + var.Data();
+  if( !cutstr.IsNull() )
+    key += string(" {") + cutstr.Data() + "}";
+  ostringstream ostr;
+  ostr << current_page << "/" << current_pad;
+  string padkey = ostr.str();
+  auto& frozen = fFrozenHists[padkey];
+  Long64_t ntotal = tree->GetEntries();
+  string input = to_string(runNumber) + " " + fConfig.GetRootFile();
+  if( frozen.key != key || frozen.input != input || !frozen.hist ||
+      ntotal < frozen.next ) {
+    // New plot for this pad, new run, or the tree was rewritten: start over
+    const TH1* golden = nullptr;
+    const string& mtitle = getMapVal(command, "title");
+    if( doGolden && !mtitle.empty() )
+      golden = dynamic_cast<TH1*>(
+        fGoldenFile->Get(TreeHistName(var, cut, drawopt, mtitle)));
+    const Binning& binning =
+      fBinning->Resolve(key, fFormulas.Get(tree, var, cutstr), golden);
+    if( !binning.IsValid() ) {
+      fFrozenHists.erase(padkey);
+      return nullptr;
+    }
+    if( fVerbosity >= 2 )
+      cout << "Binning of " << key << " from " << binning.source << endl;
+    TString title = var;
+    if( !cutstr.IsNull() )
+      title += Form(" {%s}", cutstr.Data());
+    frozen.hist.reset(binning.Book("hfrozen", title));
+    auto vars = SplitVarexp(var);
+    frozen.hist->GetXaxis()->SetTitle(vars.back().Strip(TString::kBoth));
+    if( vars.size() == 2 )
+      frozen.hist->GetYaxis()->SetTitle(vars.front().Strip(TString::kBoth));
+    tree->TAttLine::Copy(*frozen.hist);
+    tree->TAttFill::Copy(*frozen.hist);
+    tree->TAttMarker::Copy(*frozen.hist);
+    frozen.key = key;
+    frozen.input = input;
+    frozen.next = 0;
+  }
+  if( ntotal > frozen.next ) {
+    ParallelTreeFill filler(tree, var, cutstr,
+                            static_cast<unsigned>(max(fConfig.GetThreads(), 1)),
+                            &fFormulas);
+    Long64_t nsel = filler.Fill(frozen.hist.get(), frozen.next,
+                                ntotal - frozen.next);
+    if( nsel < 0 ) {
+      fFrozenHists.erase(padkey);
+      return nullptr;
+    }
+    if( fVerbosity >= 2 )
+      cout << "Filled entries " << frozen.next << " to " << ntotal
+           << " of " << key << endl;
+    frozen.next = ntotal;
+  }
+  nentries = static_cast<Long64_t>(frozen.hist->GetEntries());
+  TDirectory::TContext ctx(nullptr);
+  unique_ptr<TH1> hist(static_cast<TH1*>(frozen.hist->Clone()));
+  hist->SetDirectory(nullptr);
+  return hist;
+}
+
+//_____________________________________________________________________________
+void OnlineGUI::ProgressiveStep()
+{
+  // Called by fProgressTimer while sampled tree plots of the current page
+  // are incomplete. Adds more entries to one of them, taking turns, and
+  // redraws its pad. Each step is kept short so the GUI stays responsive.
+
+  if( fProgressive.empty() ) {
+    fProgressTimer->Stop();
+    return;
+  }
+  if( fNextProgressive >= fProgressive.size() )
+    fNextProgressive = 0;
+  auto& job = fProgressive[fNextProgressive];
+  job.fill->Step(0.2);
+  TVirtualPad* pad = job.fill->GetPad();
+  if( pad )
+    pad->Modified();
+  fCanvas->Update();
+  if( job.fill->IsDone() ) {
+    // Now complete: record and cache the final state
+    if( job.snapshot && job.fill->GetHist() )
+      fHistory.Record(job.key, job.fill->GetHist(), time(nullptr));
+    if( job.cache && pad )
+      fPadCache.Save(job.key, pad);
+    fProgressive.erase(fProgressive.begin() + fNextProgressive);
+  } else
+    ++fNextProgressive;
+  if( fProgressive.empty() )
+    fProgressTimer->Stop();
+}
+
+//_____________________________________________________________________________
+void OnlineGUI::NtupleDraw( const cmdmap_t& command, Int_t iNtuple )
+{
+  // Called by TreeDraw() if the variable is a field of an RNTuple rather
+  // than a TTree branch. Same syntax as for trees, except that projections
+  // into named histograms (">>") and profiles are not supported.
+
+  TString var = getMapVal(command, "variable");
+  if( !NtupleSource::IsSupported() ) {
+    BadDraw("RNTuple support not available");
+    return;
+  }
+  if( fVerbosity >= 2 )
+    cout << "\tProcessing from RNTuple: " << fNtuples.GetName(iNtuple) << endl;
+  Long64_t nentries = 0;
+  unique_ptr<TH1> hist = fNtuples.Draw(iNtuple, var, MakeCut(command), nentries);
+  if( !hist ) {
+    BadDraw(nentries < 0 ? var + " not found" : "Unsupported RNTuple plot");
+    return;
+  }
+  if( nentries == 0 ) {
+    BadDraw("Empty Histogram");
+    return;
+  }
+  SetupPad(command);
+  const string& mtitle = getMapVal(command, "title");
+  if( !mtitle.empty() )
+    hist->SetTitle(mtitle.c_str());
+  hist->SetStats(getMapVal(command, "nostat").empty());
+  hist->SetBit(TObject::kCanDelete);
+  TString drawopt = getMapVal(command, "drawopt");
+  hist->Draw(drawopt);
+  SaveImage(hist.get(), command);
+  hist.release();  // Owned by the pad
+}
+
+//_____________________________________________________________________________
+// Reduce the points of scatter plots in the current pad (the TGraphs that
+// TTree::Draw creates for "y:x" without a histogram option) to about one
+// per screen pixel. The statistics box is unaffected since it is computed
+// from the histogram filled with all entries. Pads that remain dense are
+// remembered for rasterization in vector output formats.
+void OnlineGUI::DecimatePad( const cmdmap_t& command )
+{
+  // Graphs with fewer points are always drawn as is
+  const size_t kMinDecimate = 10000;
+  // Rasterize pads still showing more points than this in vector formats
+  const size_t kRasterPoints = 50000;
+
+  vector<TGraph*> graphs;
+  size_t ntotal = 0;
+  TIter next(gPad->GetListOfPrimitives());
+  while( TObject* obj = next() ) {
+    if( auto* gr = dynamic_cast<TGraph*>(obj) ) {
+      graphs.push_back(gr);
+      ntotal += gr->GetN();
+    }
+  }
+  if( ntotal < kMinDecimate || !getMapVal(command, "nodecimate").empty() ) {
+    if( ntotal > kRasterPoints )
+      fDensePads.insert(current_pad);
+    return;
+  }
+
+  // Pad size in pixels
+  auto npx = static_cast<size_t>(gPad->GetWw() * gPad->GetAbsWNDC());
+  auto npy = static_cast<size_t>(gPad->GetWh() * gPad->GetAbsHNDC());
+  if( npx == 0 || npy == 0 )
+    return;
+  bool logx = gPad->GetLogx(), logy = gPad->GetLogy();
+
+  size_t nkept = 0;
+  for( auto* gr: graphs ) {
+    size_t n = gr->GetN();
+    vector<double> x(gr->GetX(), gr->GetX() + n), y(gr->GetY(), gr->GetY() + n);
+    // Work in the drawing coordinates. Non-positive values are not drawn
+    // on a log axis.
+    for( size_t i = 0; i < n; ++i ) {
+      if( logx ) x[i] = x[i] > 0 ? log10(x[i]) : NAN;
+      if( logy ) y[i] = y[i] > 0 ? log10(y[i]) : NAN;
+    }
+    vector<size_t> keep;
+    if( is_sorted(x.begin(), x.end()) ) {
+      keep = DecimateLTTB(x.data(), y.data(), n, 2 * npx);
+    } else {
+      double xmin = HUGE_VAL, xmax = -HUGE_VAL, ymin = HUGE_VAL, ymax = -HUGE_VAL;
+      for( size_t i = 0; i < n; ++i ) {
+        if( x[i] < xmin ) xmin = x[i];
+        if( x[i] > xmax ) xmax = x[i];
+        if( y[i] < ymin ) ymin = y[i];
+        if( y[i] > ymax ) ymax = y[i];
+      }
+      keep = DecimatePixelGrid(x.data(), y.data(), n,
+                               xmin, xmax, ymin, ymax, npx, npy);
+    }
+    if( keep.size() < n ) {
+      // Copy the kept points in place, then truncate
+      double* gx = gr->GetX();
+      double* gy = gr->GetY();
+      for( size_t i = 0; i < keep.size(); ++i ) {
+        gx[i] = gx[keep[i]];
+        gy[i] = gy[keep[i]];
+      }
+      gr->Set(static_cast<Int_t>(keep.size()));
+    }
+    nkept += gr->GetN();
+  }
+  if( nkept > kRasterPoints )
+    fDensePads.insert(current_pad);
+
+  if( nkept < ntotal ) {
+    if( fVerbosity >= 2 )
+      cout << "Decimated pad " << current_pad << " from " << ntotal
+           << " to " << nkept << " points" << endl;
+    TText note;
+    note.SetNDC();
+    note.SetTextAlign(31);
+    note.SetTextSize(0.035);
+    note.SetTextColor(kGray + 2);
+    note.DrawText(1. - gPad->GetRightMargin(), 1. - gPad->GetTopMargin() + 0.01,
+                  Form("%zu of %zu points shown", nkept, ntotal));
+  }
+  gPad->Modified();
+}
+
+//_____________________________________________________________________________
+// Write a short status note in the top left corner of the current pad
+void OnlineGUI::NotePad( const string& text, Color_t color ) const
+{
+  TText note;
+  note.SetNDC();
+  note.SetTextAlign(11);
+  note.SetTextSize(0.035);
+  note.SetTextColor(color);
+  TText* t = note.DrawText(gPad->GetLeftMargin(),
+                           1. - gPad->GetTopMargin() + 0.01, text.c_str());
+  t->SetName("panguin_note");
+  gPad->Modified();
+}
+
+//_____________________________________________________________________________
+// Replace the contents of the dense pads of the current page with bitmap
+// images of themselves. This keeps the size of vector output files (PDF,
+// PostScript, SVG) reasonable, at the price of losing their scalability.
+void OnlineGUI::RasterizeDensePads()
+{
+  for( auto ipad: fDensePads ) {
+    TVirtualPad* pad = fCanvas->GetPad(ipad);
+    if( !pad )
+      continue;
+    pad->Modified();
+    pad->Update();
+    TImage* img = TImage::Create();
+    if( !img )
+      return;  // No image support
+    img->FromPad(pad);
+    pad->Clear();
+    pad->cd();
+    img->SetBit(TObject::kCanDelete);
+    img->Draw("xxx");
+    if( fVerbosity >= 2 )
+      cout << "Rasterized pad " << ipad << endl;
+  }
+  fCanvas->cd();
+}
+
+void OnlineGUI::StripChartDraw( const cmdmap_t& command )
+{
+  // Called by DoDraw(), this will plot the latest entries of a tree
+  // expression as a strip chart. Only entries added since the previous
+  // update are read from the tree.
+
+  const string& expr = getMapVal(command, "expression");
+  TString var = expr;
+  UInt_t iTree = FindTreeIndex(command, var);
+  if( iTree >= fRootTree.size() ) {
+    BadDraw(var + " not found");
+    return;
+  }
+  SetupPad(command);
+
+  size_t window = 10000;
+  Long64_t nwin = TString(getMapVal(command, "window")).Atoll();
+  if( nwin > 0 )
+    window = static_cast<size_t>(nwin);
+
+  ostringstream ostr;
+  ostr << current_page << "/" << current_pad;
+  auto it = fStripCharts.find(ostr.str());
+  if( it == fStripCharts.end() || it->second.GetCapacity() != window ) {
+    fStripCharts.erase(ostr.str());
+    it = fStripCharts.emplace(ostr.str(), StripChart(window)).first;
+  }
+  auto& chart = it->second;
+
+  Long64_t nsel = chart.Update(fRootTree[iTree], var, MakeCut(command),
+                               &fFormulas);
+  if( fVerbosity >= 2 )
+    cout << "Strip chart " << var << ": " << nsel << " new values, "
+         << chart.GetSize() << " in window" << endl;
+  if( nsel < 0 ) {
+    BadDraw(var + " not found");
+    return;
+  }
+  if( chart.GetSize() == 0 ) {
+    BadDraw("Empty strip chart");
+    return;
+  }
+  auto npix = static_cast<size_t>(gPad->GetWw() * gPad->GetAbsWNDC());
+  TGraph* graph = chart.GetGraph(npix);
+  const string& mtitle = getMapVal(command, "title");
+  graph->SetTitle(mtitle.empty() ? expr.c_str() : mtitle.c_str());
+  TString drawopt = getMapVal(command, "drawopt");
+  if( drawopt.IsNull() )
+    drawopt = "AP";
+  graph->Draw(drawopt);
+  SaveImage(graph, command);
+}
+
+//_____________________________________________________________________________
+// Name under which the summaries of a plot are kept in the trend store:
+// the histogram name or tree expression, followed by the cut, if any
+static string TrendName( const OnlineGUI::cmdmap_t& command )
+{
+  string name = getMapVal(command, "variable");
+  const string& cut = getMapVal(command, "cut");
+  if( !cut.empty() )
+    name += " {" + cut + "}";
+  return name;
+}
+
+//_____________________________________________________________________________
+// Queue the summary of the histogram in the current pad for the trend
+// store. Called for each pad in batch mode.
+void OnlineGUI::TrendRecord( const cmdmap_t& command )
+{
+  if( fTrend.GetFile().empty() || runNumber == 0 )
+    return;
+  const string& cmd = getMapVal(command, "variable");
+  if( cmd.empty() || cmd == "macro" || cmd == "loadmacro" ||
+      cmd == "loadlib" || cmd == "trend" )
+    return;
+  TH1* hist = nullptr;
+  TIter next(gPad->GetListOfPrimitives());
+  while( auto* obj = next() ) {
+    if( auto* h = dynamic_cast<TH1*>(obj) )
+      hist = h;   // Last one drawn is the current one (golden is drawn first)
+  }
+  if( hist )
+    fTrend.Add(runNumber, TrendName(command), TrendStore::Summarize(hist));
+}
+
+//_____________________________________________________________________________
+void OnlineGUI::TrendDraw( const cmdmap_t& command )
+{
+  // Called by DoDraw(), this will plot a summary quantity of another plot
+  // vs. run number, as recorded in the trend store by earlier batch runs.
+
+  if( fTrend.GetFile().empty() ) {
+    BadDraw("No trendfile defined");
+    return;
+  }
+  SetupPad(command);
+  const string& name = getMapVal(command, "expression");
+  const string& quantity = getMapVal(command, "quantity");
+  Long64_t nruns = TString(getMapVal(command, "window")).Atoll();
+  TGraphErrors* graph =
+    fTrend.MakeGraph(name, quantity, nruns > 0 ? nruns : 0);
+  if( !graph ) {
+    BadDraw("No " + quantity + " trend for " + name);
+    return;
+  }
+  const string& mtitle = getMapVal(command, "title");
+  graph->SetTitle(mtitle.empty() ? (name + " " + quantity).c_str()
+                                 : mtitle.c_str());
+  graph->GetXaxis()->SetTitle("Run");
+  graph->GetYaxis()->SetTitle(quantity.c_str());
+  graph->SetMarkerStyle(20);
+  graph->SetMarkerSize(0.6);
+  graph->SetBit(TObject::kCanDelete);
+  TString drawopt = getMapVal(command, "drawopt");
+  if( drawopt.IsNull() )
+    drawopt = "ALP";
+  graph->Draw(drawopt);
+  SaveImage(graph, command);
+}
+
 void OnlineGUI::PrintToFile()
 {
   // Routine to print the current page to a File.
@@ -1331,8 +2515,17 @@ void OnlineGUI::PrintToFile()
   fi.fIniDir = StrDup(dir.Data());
 
   new TGFileDialog(gClient->GetRoot(), fMain, kFDSave, &fi);
-  if( fi.fFilename )
-    fCanvas->Print(fi.fFilename);
+  if( !fi.fFilename )
+    return;
+  TString filename = fi.fFilename;
+  Ssiz_t dot = filename.Last('.');
+  bool rasterize = !fDensePads.empty() && dot != kNPOS &&
+                   IsVectorFormat(filename(dot + 1, filename.Length()));
+  if( rasterize )
+    RasterizeDensePads();
+  fCanvas->Print(filename);
+  if( rasterize )
+    DoDraw();  // Bring back the interactive plots
 }
 
 void OnlineGUI::PrintPages()
@@ -1349,9 +2542,11 @@ void OnlineGUI::PrintPages()
   Bool_t pagePrint = kFALSE;
   TString printFormat = fConfig.GetPlotFormat();
   cout << "Plot Format = " << printFormat << endl;
+  // JSON: one file per pad, in a directory named like the summary file
+  Bool_t jsonPrint = (printFormat == "json");
   if( printFormat.IsNull() )
     printFormat = "pdf";
-  else if( printFormat != "pdf" )
+  else if( printFormat != "pdf" && !jsonPrint )
     pagePrint = kTRUE;
 
   string protofilename = pagePrint ? fConfig.GetProtoPlotPageFile()
@@ -1363,6 +2558,27 @@ void OnlineGUI::PrintPages()
     if( MakePlotsDir(outdir) )
       throw runtime_error("Bad directory name");
   }
+  unique_ptr<JsonExport> json;
+  if( jsonPrint ) {
+    // Directory named like the summary file, less any extension
+    Ssiz_t dot = filename.Last('.');
+    if( dot != kNPOS && dot > filename.Last('/') )
+      filename.Remove(dot);
+    if( MakePlotsDir(filename.Data()) )
+      throw runtime_error("Bad directory name");
+    json.reset(new JsonExport(filename.Data(), fConfig.DoJsonCompress(),
+                              fConfig.GetJsrootUrl()));
+  }
+  unique_ptr<ArchiveWriter> archive;
+  if( !fConfig.GetArchiveFile().empty() ) {
+    auto archivefile = SubstitutePlaceholders(fConfig.GetArchiveFile());
+    if( MakePlotsDir(DirnameStr(archivefile)) )
+      throw runtime_error("Bad directory name");
+    archive.reset(new ArchiveWriter(archivefile,
+                                    fConfig.GetArchiveCompression()));
+    if( !archive->IsOpen() )
+      archive.reset();
+  }
 
   TString pagehead = "Summary Plots";
   if( runNumber != 0 ) {
@@ -1378,18 +2594,33 @@ void OnlineGUI::PrintPages()
   gStyle->SetPadBorderMode(0);
   //gStyle->SetHistLineColor(1);
   gStyle->SetHistFillStyle(0);
-  if( !pagePrint )
+  if( !pagePrint && !json )
     fCanvas->Print(filename + "[");
   for( Int_t i = 0; i < SINT(fConfig.GetPageCount()); i++ ) {
     current_page = i;
     DoDraw();
+    if( archive ) {
+      UInt_t npads = fConfig.GetDrawCount(current_page);
+      for( current_pad = 1; current_pad <= SINT(npads); ++current_pad )
+        archive->AddPad(SubstitutePlaceholders("page%P/pad%D"),
+                        fCanvas->GetPad(current_pad));
+    }
     TString pagename = pagehead;
     pagename += " ";
     pagename += i + 1;
     pagename += ": ";
     pagename += fConfig.GetPageTitle(current_page);
+    if( json ) {
+      Int_t nx, ny;
+      std::tie(nx, ny) = fConfig.GetPageDim(current_page);
+      json->AddPage(fConfig.GetPageTitle(current_page), pagename, fCanvas,
+                    nx, ny);
+      continue;
+    }
     lt->SetTextSize(0.025);
     lt->DrawLatex(0.05, 0.98, pagename);
+    if( IsVectorFormat(printFormat) )
+      RasterizeDensePads();
     if( pagePrint ) {
       filename = SubstitutePlaceholders(protofilename);
       cout << "Printing page " << current_page + 1
@@ -1400,9 +2631,97 @@ void OnlineGUI::PrintPages()
     }
     fCanvas->Print(filename);
   }
-  if( !pagePrint )
+  if( json ) {
+    if( json->Close(pagehead, runNumber, fConfig.GetConfFileName()) )
+      cout << "Wrote " << fConfig.GetPageCount() << " pages in JSON format "
+           << "to " << json->GetDir() << endl;
+  } else if( !pagePrint )
     fCanvas->Print(filename + "]");
 
+  if( fBudget )
+    fBudget->Report(cout);
+
+  if( archive ) {
+    Int_t nobj = archive->Close();
+    cout << "Wrote " << nobj << " plot objects to " << archive->GetName()
+         << endl;
+  }
+
+  Int_t ntrend = fTrend.Write();
+  if( ntrend > 0 )
+    cout << "Added " << ntrend << " plot summaries for run " << runNumber
+         << " to trend file " << fTrend.GetFile() << endl;
+
+}
+
+//_____________________________________________________________________________
+// Headless server mode (--serve). Draw all pages whenever the input has
+// changed, and publish them to thin clients (panguin -L server:<host>:<port>)
+// in between. The plots are computed once per update, regardless of the
+// number of clients.
+void OnlineGUI::Serve()
+{
+  PageServer server(fConfig.GetServePort());
+  if( !server.IsValid() )
+    throw runtime_error("Cannot start page server");
+  cout << "Serving " << fConfig.GetPageCount() << " pages on port "
+       << fConfig.GetServePort() << endl;
+
+  fCanvas = new TCanvas("fCanvas", "panguin server", 1000, 800);
+  Long_t interval = fConfig.GetUpdateTime() > 0 ? fConfig.GetUpdateTime()
+                                                : UPDATETIME;
+  time_t tlast = 0;
+  for( ;; ) {
+    // Live sources must be polled. Files are reread only when modified
+    if( fLive || !fFileAlive || GetRootFileTime() != tlast ) {
+      fFileAlive = ReopenInput();
+      if( fFileAlive ) {
+        tlast = GetRootFileTime();
+        for( Int_t i = 0; i < SINT(fConfig.GetPageCount()); i++ ) {
+          current_page = i;
+          fTakeSnapshot = kTRUE;  // Counts as monitor update for "-every"
+          DoDraw();
+          server.SetPage(i, fCanvas, runNumber, tlast);
+          // Answer pending requests, with the previous version of the pages
+          // not redrawn yet, so that clients do not time out
+          server.Serve(0);
+        }
+        if( fVerbosity >= 1 )
+          cout << "Updated pages for run " << runNumber << endl;
+      }
+    }
+    server.Serve(interval);
+  }
+}
+
+//_____________________________________________________________________________
+// Thin client: draw the current page as received from the server
+void OnlineGUI::ServedPageDraw()
+{
+  Int_t run = runNumber;
+  unique_ptr<TCanvas> page(fLive->FetchPage(current_page, run));
+  fCanvas->cd();
+  if( !page ) {
+    // Server busy or gone: keep showing the last version of the page
+    auto last = fServedPages.find(current_page);
+    if( last == fServedPages.end() ) {
+      BadDraw("Page not available from server");
+      return;
+    }
+    last->second->DrawClonePad();
+    fCanvas->cd();
+    NotePad("not updated: no reply from server", kGray + 2);
+    return;
+  }
+  page->DrawClonePad();
+  fServedPages[current_page] = std::move(page);
+  if( run != runNumber && fRunNumber ) {
+    runNumber = run;
+    TString rnBuff = "Run #";
+    rnBuff += runNumber;
+    fRunNumber->SetText(rnBuff.Data());
+    hframe->Layout();
+  }
 }
 
 //_____________________________________________________________________________
@@ -1431,7 +2750,7 @@ void OnlineGUI::InspectRootFile( const string& scanfile )
     delete fRootFile; fRootFile = nullptr;
     return;
   }
-  vector<const RootFileObj*> hists, trees, misc;
+  vector<const RootFileObj*> hists, trees, ntuples, misc;
   int typew = 0, namew = 0;
   GetFileObjects();
   auto nobj = fileObjects.size();
@@ -1441,6 +2760,8 @@ void OnlineGUI::InspectRootFile( const string& scanfile )
       hists.push_back(&fobj);
     else if( fobj.type == "TTree" )
       trees.push_back(&fobj);
+    else if( NtupleSource::IsNtupleClass(fobj.type) )
+      ntuples.push_back(&fobj);
     else
       misc.push_back(&fobj);
     if( fobj.type.Length() > typew )
@@ -1465,6 +2786,21 @@ void OnlineGUI::InspectRootFile( const string& scanfile )
     cout << endl;
   }
 
+  if( !ntuples.empty() ) {
+    fNtuples.Scan({scanfile});
+    cout << ntuples.size() << " RNTuples:" << endl;
+    for( const auto* fobj: ntuples ) {
+      Print(*fobj, typew, namew, false);
+      Int_t i = fNtuples.FindIndex("", fobj->name.Data());
+      if( i >= 0 ) {
+        for( const auto& field: fNtuples.GetFields(i) )
+          cout << "    " << field << endl;
+      }
+    }
+    fNtuples.Clear();
+    cout << endl;
+  }
+
   if( !misc.empty() ) {
     cout << misc.size() << " other objects:" << endl;
     for( const auto* fobj: misc )
@@ -1487,6 +2823,7 @@ void OnlineGUI::DeleteGUI()
 {
   DelPtr(timer);
   DelPtr(timerNow);
+  DelPtr(fProgressTimer);
   fMain->Cleanup();   // Without this, ROOT will crash on exit
   //DelPtr(fMain);    // Don't. ROOT will clean it up on exit
 }
@@ -1498,6 +2835,8 @@ void OnlineGUI::MyCloseWindow()
   if( timer ) {
     timer->Stop();
   }
+  if( fProgressTimer )
+    fProgressTimer->Stop();
   DeleteGUI();
 
   gApplication->Terminate();
@@ -1515,6 +2854,8 @@ OnlineGUI::~OnlineGUI()
 {
   if( timer )
     timer->Stop();
+  if( fProgressTimer )
+    fProgressTimer->Stop();
   if( fMain ) {
     fMain->SendCloseMessage();
     DeleteGUI();
@@ -8,9 +8,11 @@
 #include <stdexcept>
 #include <iomanip>    // quoted, setw, setfill
 #include <cctype>     // isalnum, isdigit, isspace
+#include <cstdlib>    // getenv, strtod
 #include <algorithm>  // find_if
 #include <type_traits>// make_signed
 #include <sys/stat.h>
+#include <glob.h>
 #if __cplusplus >= 201703L
 #include <regex>
 #endif
@@ -42,6 +44,35 @@ bool EndsWith( const string& str, const string& tail )
   return sl >= tl && str.substr(sl - tl, tl) == tail;
 }
 
+//_____________________________________________________________________________
+// Convert a time interval like "500ms", "60s", "2m" or "1h" to milliseconds.
+// A number without unit is in seconds. Returns -1 if 'str' is not a valid,
+// positive interval.
+long long ParseInterval( const string& str )
+{
+  char* end = nullptr;
+  double t = strtod(str.c_str(), &end);
+  if( str.empty() || end == str.c_str() || !(t > 0) )
+    return -1;
+  string unit(end);
+  if( unit.empty() || unit == "s" )
+    t *= 1e3;
+  else if( unit == "m" || unit == "min" )
+    t *= 60e3;
+  else if( unit == "h" )
+    t *= 3600e3;
+  else if( unit != "ms" )
+    return -1;
+  return (t >= 1) ? static_cast<long long>(t + 0.5) : -1;
+}
+
+//_____________________________________________________________________________
+// Commands within a page that set page options rather than define a plot
+static bool IsPageOption( const string& cmd )
+{
+  return cmd == "title" || cmd == "every" || cmd == "refresh";
+}
+
 //_____________________________________________________________________________
 // Get directory name part of 'path'
 string DirnameStr( string path )
@@ -116,6 +147,53 @@ OpenInPath( const string& filename, const string& path, ifstream& infile )
   return foundpath;
 }
 
+//_____________________________________________________________________________
+// Check if 'filename' contains shell wildcard characters
+static bool IsGlob( const string& filename )
+{
+  return filename.find_first_of("*?[") != string::npos;
+}
+
+//_____________________________________________________________________________
+// Return the regular files matching the wildcard 'pattern', sorted by name
+static VecStr_t GlobFiles( const string& pattern )
+{
+  VecStr_t files;
+  glob_t gl{};
+  if( glob(pattern.c_str(), 0, nullptr, &gl) == 0 ) {
+    for( size_t i = 0; i < gl.gl_pathc; ++i ) {
+      struct stat fs{};
+      if( stat(gl.gl_pathv[i], &fs) == 0 && S_ISREG(fs.st_mode) )
+        files.emplace_back(gl.gl_pathv[i]);
+    }
+  }
+  globfree(&gl);
+  return files;
+}
+
+//_____________________________________________________________________________
+// Like OpenInPath, but for a wildcard 'pattern'. Returns the directory where
+// matching files were found and the matching files in 'files'.
+static string
+GlobInPath( const string& pattern, const string& path, VecStr_t& files )
+{
+  files = GlobFiles(pattern);
+  if( !files.empty() )
+    return DirnameStr(pattern);
+  if( pattern.empty() || pattern[0] == '/' )
+    return {};
+  string trypath;
+  istringstream istr(path);
+  while( getline(istr, trypath, ':') ) {
+    if( trypath.empty() )
+      continue;
+    files = GlobFiles(trypath + "/" + pattern);
+    if( !files.empty() )
+      return DirnameStr(trypath + "/" + pattern);
+  }
+  return {};
+}
+
 //_____________________________________________________________________________
 // Append 'dir' to 'path'
 static void AppendToPath( string& path, const string& dir )
@@ -261,6 +339,15 @@ static int StrToIntRange( const string& str, int lo, int hi, const string& name
   return i;
 }
 
+//_____________________________________________________________________________
+// Returns true if 'str' is a number in the interval (0,1], and its value in 'x'
+static bool IsFraction( const string& str, double& x )
+{
+  char* end = nullptr;
+  x = strtod(str.c_str(), &end);
+  return !str.empty() && *end == '\0' && x > 0 && x <= 1;
+}
+
 //_____________________________________________________________________________
 // Default constructor. Create empty/default config. Does not load anything.
 OnlineConfig::OnlineConfig()
@@ -293,7 +380,23 @@ OnlineConfig::OnlineConfig( const CmdLineOpts& opts )
   , fPadNoWidth(2)
   , fPrintOnly(opts.printonly)
   , fSaveImages(opts.saveimages)
+  , fHistoryBudget(64)
+  , fUpdateTime(0)
+  , fServePort(opts.serveport)
+  , fJsonCompress(false)
+  , fArchiveCompression(-1)
+  , fProgressiveEntries(0)
+  , fSampleFraction(0.01)
+  , fPadBudget(0)
+  , fPageBudget(0)
+  , fFixBinning(false)
+  , fThreads(opts.threads)
+  , fMergeAll(false)
 {
+  fLiveSource = opts.livesource;
+  for( const auto& mf: opts.mergefiles )
+    fMergeFiles.push_back(ExpandFileName(mf));
+
   if( confFileName.empty() )
     return;  // Pick up config file directory/path form environment.
   // A config dir or path given on the command line takes preference.
@@ -585,6 +688,7 @@ bool OnlineConfig::ParseConfig()
     pageInfo.clear();
     auto first_page = ParsePageInfo(ALL(sConfFile), pageInfo);
 
+    bool merge_from_cli = !fMergeFiles.empty();
     // List of defined commands and corresponding actions
     vector<CommandDef> cmddefs = {
       {"watchfile",
@@ -619,6 +723,20 @@ bool OnlineConfig::ParseConfig()
         if( !IsSet(goldenrootfilename, line[0]) )
           goldenrootfilename = ExpandFileName(line[1]);
       }},
+      {"mergefiles",
+        101, [&]( const VecStr_t& line ) {
+        if( merge_from_cli ) {
+          cerr << "Warning: Command line option for " << line[0]
+               << " overrides value in configuration file." << endl;
+          return;
+        }
+        for( size_t i = 1; i < line.size(); ++i )
+          fMergeFiles.push_back(ExpandFileName(line[i]));
+      }},
+      {"mergeall",
+        0, [&]( const VecStr_t& ) {
+        fMergeAll = true;
+      }},
       {"protorootfile",
         1, [&]( const VecStr_t& line ) {
         fProtoRootFiles.push_back(ExpandFileName(line[1]));
@@ -667,6 +785,70 @@ bool OnlineConfig::ParseConfig()
         1, [&]( const VecStr_t& line ) {
         fProtoMacroImageFile = ExpandFileName(line[1]);
       }},
+      {"livesource",
+        1, [&]( const VecStr_t& line ) {
+        if( !IsSet(fLiveSource, line[0]) )
+          fLiveSource = line[1];
+      }},
+      {"updatetime",
+        1, [&]( const VecStr_t& line ) {
+        fUpdateTime = StrToIntRange(line[1], 100, 3600000,
+                                    "updatetime (ms)");
+      }},
+      {"jsoncompress",
+        0, [&]( const VecStr_t& ) {
+        fJsonCompress = true;
+      }},
+      {"jsrooturl",
+        1, [&]( const VecStr_t& line ) {
+        fJsrootUrl = line[1];
+      }},
+      {"archivefile",
+        1, [&]( const VecStr_t& line ) {
+        fArchiveFile = ExpandFileName(line[1]);
+      }},
+      {"archivecompression",
+        1, [&]( const VecStr_t& line ) {
+        fArchiveCompression = StrToIntRange(line[1], 0, 509,
+                                            "archivecompression");
+      }},
+      {"progressive",
+        101, [&]( const VecStr_t& line ) {
+        fProgressiveEntries = StrToIntRange(line[1], 0, 2000000000,
+                                            "progressive (entries)");
+        if( line.size() > 2 && !IsFraction(line[2], fSampleFraction) )
+          throw std::runtime_error("progressive: sample fraction must be "
+                                   "> 0 and <= 1, got " + line[2]);
+      }},
+      {"padbudget",
+        1, [&]( const VecStr_t& line ) {
+        fPadBudget = StrToIntRange(line[1], 0, 3600000, "padbudget (ms)");
+      }},
+      {"pagebudget",
+        1, [&]( const VecStr_t& line ) {
+        fPageBudget = StrToIntRange(line[1], 0, 3600000, "pagebudget (ms)");
+      }},
+      {"threads",
+        1, [&]( const VecStr_t& line ) {
+        int nthreads = StrToIntRange(line[1], 1, 1024, "threads");
+        if( fThreads == 0 )  // Command line takes precedence
+          fThreads = nthreads;
+      }},
+      {"fixbinning",
+        100, [&]( const VecStr_t& line ) {
+        fFixBinning = true;
+        if( line.size() > 1 )
+          fBinningFile = ExpandFileName(line[1]);
+      }},
+      {"trendfile",
+        1, [&]( const VecStr_t& line ) {
+        fTrendFile = ExpandFileName(line[1]);
+      }},
+      {"historybudget",
+        1, [&]( const VecStr_t& line ) {
+        fHistoryBudget = StrToIntRange(line[1], 0, 65536,
+                                       "historybudget (MB)");
+      }},
       {"ndigits",
         3, [&]( const VecStr_t& line ) {
         fRunNoWidth = StrToIntRange(line[1], 0, 8, "ndigits run number width");
@@ -678,6 +860,21 @@ bool OnlineConfig::ParseConfig()
 
     ParseCommands(sConfFile.begin(), first_page, cmddefs);
 
+    // Check the refresh cadence of pages and plots
+    for( auto pos = first_page; pos != sConfFile.end(); ++pos ) {
+      const auto& line = *pos;
+      for( size_t i = 0; i < line.size(); ++i ) {
+        const string& opt = (i == 0 && !line[i].empty()) ? "-" + line[i] : line[i];
+        if( opt != "-every" && opt != "-refresh" )
+          continue;
+        if( i + 1 >= line.size() ||
+            (opt == "-every" && atoi(line[i + 1].c_str()) < 1) ||
+            (opt == "-refresh" && ParseInterval(line[i + 1]) < 0) )
+          throw std::runtime_error("Bad value for " + line[i] + ": " +
+                                   (i + 1 < line.size() ? line[i + 1] : "(none)"));
+      }
+    }
+
     if( fVerbosity >= 3 ) {
       cout << "OnlineConfig::ParseConfig()\n";
       for( uint_t i = 0; i < GetPageCount(); i++ ) {
@@ -690,7 +887,28 @@ bool OnlineConfig::ParseConfig()
     cout << "Number of pages defined = " << GetPageCount() << endl;
     cout << "Number of cuts defined = " << cutList.size() << endl;
 
-    if( rootfilename.empty() && fRunNumber != 0)
+    if( IsPageClient() ) {
+      // Thin client. Pages are drawn by a panguin server
+      if( fServePort > 0 )
+        throw std::runtime_error("Cannot serve pages received from "
+                                 "another server");
+      fMonitor = true;
+      rootfilename.clear();
+      fMergeFiles.clear();
+      cout << "Showing pages from panguin " << fLiveSource << endl;
+    } else if( !fLiveSource.empty() ) {
+      // Histograms come from a running analyzer, not from a file
+      fMonitor = true;
+      rootfilename.clear();
+      fMergeFiles.clear();
+      cout << "Reading histograms from live source " << fLiveSource << endl;
+    } else if( !fMergeFiles.empty() ) {
+      if( !rootfilename.empty() )
+        cout << "Notice: Both ROOT file and files to merge specified. "
+             << "Merging files." << endl;
+      rootfilename.clear();
+      cout << "Merging " << GetRootFiles().size() << " ROOT files" << endl;
+    } else if( rootfilename.empty() && fRunNumber != 0)
       OverrideRootFile(fRunNumber);
     else if( !rootfilename.empty() ) {
       if (fRunNumber != 0)
@@ -698,6 +916,9 @@ bool OnlineConfig::ParseConfig()
 	     << "Using ROOT file from commandline." << endl;
       rootfilename = ExpandFileName(rootfilename);
       cout << "Using ROOT file " << rootfilename << endl;
+      if( IsGlob(rootfilename) )
+        cout << "Found " << GlobFiles(rootfilename).size()
+             << " segment files" << endl;
       int runnum = ExtractRunNumber(rootfilename);
       cout << "Run number extracted from file name = " << runnum << endl;
       if (fRunNumber==0 && runnum!=0)
@@ -898,7 +1119,7 @@ vector<uint_t> OnlineConfig::GetDrawIndex( uint_t page )
   uint_t iter_command = pageInfo[page].first + 1;
 
   for( uint_t i = 0; i < pageInfo[page].second; i++ ) {
-    if( sConfFile[iter_command + i][0] != "title" ) {
+    if( !IsPageOption(sConfFile[iter_command + i][0]) ) {
       index.push_back(iter_command + i);
     }
   }
@@ -913,7 +1134,7 @@ uint_t OnlineConfig::GetDrawCount( uint_t page )
   uint_t draw_count = 0;
 
   for( uint_t i = 0; i < pageInfo[page].second; i++ ) {
-    if( sConfFile[pageInfo[page].first + i + 1][0] != "title" ) draw_count++;
+    if( !IsPageOption(sConfFile[pageInfo[page].first + i + 1][0]) ) draw_count++;
   }
 
   return draw_count;
@@ -931,7 +1152,16 @@ uint_t OnlineConfig::GetDrawCount( uint_t page )
 //  5. "-logx, -logy, -logz" --> draw with log x,y,z axis
 //  6. "-nostat" --> don't show stats box
 //  7. "-noshowgolden" --> don't show "golden" histogram even if goldenrootfile is defined
-//  8. any option not preceded by these indicators is assumed to be a cut or macro expression:
+//  8. "-golden" --> compare 2D/3D histogram with golden: "ratio", "diff" or "pull"
+//  9. "-window" --> number of entries to show in a strip chart, or of runs in a trend
+// 10. "-nodecimate" --> draw all points of dense scatter plots
+// 11. "-overlay" --> overlay histogram from earlier runs: "last:N" or "run1,run2,..."
+// 12. "-sample" --> draw tree variable from a fraction of the entries first (optional
+//     fraction follows, default from "progressive"), then refine it in the GUI
+// 13. "-every", "-refresh" --> in monitor mode, recompute the plot only every N updates
+//     or after the given time ("60s"), show the previous result in between.
+//     Defaults to the page's "every" or "refresh" command, if any.
+// 14. any option not preceded by these indicators is assumed to be a cut or macro expression:
 // what options do we want?
 //  all options on one line. First argument assumed to be histogram or tree name (or "macro")
 //
@@ -970,6 +1200,33 @@ void OnlineConfig::GetDrawCommand(
       out_command.clear();
       return;
     }
+  } else if( out_command["variable"] == "stripchart" ) {
+    if( nfields > 1 ) {
+      out_command["expression"] = line[1];
+      nexti = 2;  // parse options below
+    } else {
+      cerr << "Error: stripchart command without expression "
+           << "at page/command = " << page << "/" << nCommand
+           << endl;
+      out_command.clear();
+      return;
+    }
+  } else if( out_command["variable"] == "trend" ) {
+    if( nfields > 1 ) {
+      out_command["expression"] = line[1];
+      out_command["quantity"] = "mean";
+      nexti = 2;  // parse options below
+      if( nfields > 2 && line[2][0] != '-' ) {
+        out_command["quantity"] = line[2];
+        nexti = 3;
+      }
+    } else {
+      cerr << "Error: trend command without plot name "
+           << "at page/command = " << page << "/" << nCommand
+           << endl;
+      out_command.clear();
+      return;
+    }
   } else if( out_command["variable"] == "loadmacro" ) {
     if( nfields > 2 ) {
       out_command["library"] = line[1]; //shared library to load
@@ -1039,8 +1296,33 @@ void OnlineConfig::GetDrawCommand(
       out_command["logz"] = "logz";
     } else if( line[i] == "-nostat" ) {
       out_command["nostat"] = "nostat";
+    } else if( line[i] == "-nodecimate" ) {
+      out_command["nodecimate"] = "nodecimate";
     } else if( line[i] == "-noshowgolden" ) {
       out_command["noshowgolden"] = "noshowgolden";
+    } else if( line[i] == "-golden" && i + 1 < nfields ) {
+      out_command["golden"] = line[i + 1];
+      i++;
+    } else if( line[i] == "-overlay" && i + 1 < nfields ) {
+      out_command["overlay"] = line[i + 1];
+      i++;
+    } else if( line[i] == "-sample" ) {
+      double x;
+      if( i + 1 < nfields && IsFraction(line[i + 1], x) ) {
+        out_command["sample"] = line[i + 1];
+        i++;
+      } else {
+        out_command["sample"] = "default";
+      }
+    } else if( line[i] == "-every" && i + 1 < nfields ) {
+      out_command["every"] = line[i + 1];
+      i++;
+    } else if( line[i] == "-refresh" && i + 1 < nfields ) {
+      out_command["refresh"] = line[i + 1];
+      i++;
+    } else if( line[i] == "-window" && i + 1 < nfields ) {
+      out_command["window"] = line[i + 1];
+      i++;
     } else {  // every thing else is regarded as cut
       out_command["cut"] = line[i];
       // if (out_command[1].empty()) {
@@ -1052,6 +1334,17 @@ void OnlineConfig::GetDrawCommand(
     }
   }
 
+  // Page default for the refresh cadence
+  if( out_command.count("every") == 0 && out_command.count("refresh") == 0 ) {
+    uint_t iter_command = pageInfo[page].first + 1;
+    for( uint_t j = 0; j < pageInfo[page].second; j++ ) {
+      const auto& pageline = sConfFile[iter_command + j];
+      if( (pageline[0] == "every" || pageline[0] == "refresh") &&
+          pageline.size() > 1 )
+        out_command[pageline[0]] = pageline[1];
+    }
+  }
+
   if( fVerbosity >= 1 ) {
     cout << nfields << ": ";
     for( const auto& field: line ) {
@@ -1067,13 +1360,84 @@ void OnlineConfig::GetDrawCommand(
 }
 
 //_____________________________________________________________________________
-// Override the ROOT file defined in the cfg file. This is called when the
-// user specifies a run number on the command line.
-void OnlineConfig::OverrideRootFile( int runnumber )
+// Check if several ROOT files are to be processed together: either the
+// ROOT file name is a wildcard pattern selecting the segment files of a run
+// (e.g. run_1234_*.root), or a list of files to merge was given.
+bool OnlineConfig::IsMultiFile() const
 {
-  if( !rootfilename.empty() )
-    cout << "Root file defined before was: " << rootfilename << endl;
+  return !fMergeFiles.empty() || IsGlob(rootfilename);
+}
+
+//_____________________________________________________________________________
+// Return the ROOT files to process. Wildcard patterns are expanded afresh on
+// each call, so that new files are picked up.
+VecStr_t OnlineConfig::GetRootFiles() const
+{
+  if( IsLive() )
+    return {};
+  if( fMergeFiles.empty() ) {
+    if( IsGlob(rootfilename) )
+      return GlobFiles(rootfilename);
+    return {rootfilename};
+  }
+  VecStr_t files;
+  for( const auto& mf: fMergeFiles ) {
+    VecStr_t found = IsGlob(mf) ? GlobFiles(mf) : VecStr_t{mf};
+    for( auto& file: found ) {
+      if( find(ALL(files), file) == files.end() )
+        files.push_back(std::move(file));
+    }
+  }
+  return files;
+}
 
+//_____________________________________________________________________________
+// Names of all histograms, or tree variables, drawn on any page. This
+// limits the objects that need to be read when merging files.
+VecStr_t OnlineConfig::GetReferencedObjects()
+{
+  VecStr_t names;
+  map<string, string> command;
+  for( uint_t page = 0; page < GetPageCount(); ++page ) {
+    for( uint_t i = 0; i < GetDrawCount(page); ++i ) {
+      GetDrawCommand(page, i, command);
+      const string& var = command["variable"];
+      if( var.empty() || var == "macro" || var == "loadmacro" ||
+          var == "loadlib" || var == "stripchart" || var == "trend" )
+        continue;
+      if( find(ALL(names), var) == names.end() )
+        names.push_back(var);
+    }
+  }
+  return names;
+}
+
+//_____________________________________________________________________________
+// Names of the histograms to merge from the files of a run, or an empty list
+// for all of them. Macros may get any object from the file by name, so all
+// are merged if there are macros, or if "mergeall" was given.
+VecStr_t OnlineConfig::GetMergeSelection()
+{
+  if( fMergeAll )
+    return {};
+  map<string, string> command;
+  for( uint_t page = 0; page < GetPageCount(); ++page ) {
+    for( uint_t i = 0; i < GetDrawCount(page); ++i ) {
+      GetDrawCommand(page, i, command);
+      const string& var = command["variable"];
+      if( var == "macro" || var == "loadmacro" )
+        return {};
+    }
+  }
+  return GetReferencedObjects();
+}
+
+//_____________________________________________________________________________
+// Search the ROOT file of run 'runnumber' using the protorootfile patterns.
+// Returns the file name (a wildcard pattern for runs split into segments),
+// or an empty string if not found.
+string OnlineConfig::LocateRootFile( int runnumber, bool verbose ) const
+{
   string fnmRootPath;
   AppendToPath(fnmRootPath, fRootFilesPath);
   auto* envar = getenv("ROOTFILES");
@@ -1081,28 +1445,61 @@ void OnlineConfig::OverrideRootFile( int runnumber )
     AppendToPath(fnmRootPath, envar);
   AppendToPath(fnmRootPath, "rootfiles");
 
-  bool found = false;
-  for( auto& protofile: fProtoRootFiles ) {
+  for( const auto& proto: fProtoRootFiles ) {
     // try opening protofile in path
-    assert(!protofile.empty());  // else error in ParseConfig
-    cout << " Looking for protoROOT file " << protofile
-	 << " with runnumber " << runnumber
-         << " in " << fnmRootPath << endl;
-    protofile = SubstituteRunNumber(protofile, runnumber);
+    assert(!proto.empty());  // else error in ParseConfig
+    if( verbose )
+      cout << " Looking for protoROOT file " << proto
+           << " with runnumber " << runnumber
+           << " in " << fnmRootPath << endl;
+    string protofile = SubstituteRunNumber(proto, runnumber);
+    if( IsGlob(protofile) ) {
+      // Run split into several segment files
+      VecStr_t files;
+      string fp = GlobInPath(protofile, fnmRootPath, files);
+      if( !files.empty() ) {
+        if( verbose )
+          cout << "\t found " << files.size() << " segment files" << endl;
+        return fp + "/" + BasenameStr(protofile);
+      }
+      continue;
+    }
     ifstream ifs;
     string fp = OpenInPath(protofile, fnmRootPath, ifs);
-    if( ifs ) {
-      rootfilename = fp + "/" + BasenameStr(protofile);
-      found = true;
-      break;
-    }
+    if( ifs )
+      return fp + "/" + BasenameStr(protofile);
   }
+  return {};
+}
+
+//_____________________________________________________________________________
+// Return the ROOT file(s) of run 'runnumber', e.g. for comparisons with
+// earlier runs. Empty if the run is not found.
+VecStr_t OnlineConfig::FindRunFiles( int runnumber ) const
+{
+  string file = LocateRootFile(runnumber, false);
+  if( file.empty() )
+    return {};
+  if( IsGlob(file) )
+    return GlobFiles(file);
+  return {file};
+}
+
+//_____________________________________________________________________________
+// Override the ROOT file defined in the cfg file. This is called when the
+// user specifies a run number on the command line.
+void OnlineConfig::OverrideRootFile( int runnumber )
+{
+  if( !rootfilename.empty() )
+    cout << "Root file defined before was: " << rootfilename << endl;
 
-  if( !found ) {
+  string found = LocateRootFile(runnumber, true);
+  if( found.empty() ) {
     cout << "No ROOT file found. Double check your configurations and files. "
          << "Quitting ..." << endl;
     exit(1);
   }
+  rootfilename = found;
   cout << "\t found file " << rootfilename << endl;
 
   fRunNumber = runnumber;
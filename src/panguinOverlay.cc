@@ -0,0 +1,101 @@
+///////////////////////////////////////////////////////////////////
+//  Histograms of earlier runs for overlays
+///////////////////////////////////////////////////////////////////
+
+#include "panguinOverlay.hh"
+#include <TFile.h>
+#include <TDirectory.h>
+#include <iostream>
+#include <algorithm>
+
+using namespace std;
+
+// How far back to look for earlier runs. Run numbers need not be
+// consecutive, but gaps are usually small.
+static const Int_t kMaxRunGap = 100;
+
+//_____________________________________________________________________________
+RunOverlayCache::RunOverlayCache( size_t capacity, Finder_t finder )
+  : fCapacity{max<size_t>(capacity, 1)}
+  , fFinder{std::move(finder)}
+{
+}
+
+//_____________________________________________________________________________
+// Files of 'run', as returned by the finder. Lookups, including those for
+// runs that do not exist, are remembered.
+const vector<string>& RunOverlayCache::GetRunFiles( Int_t run )
+{
+  auto it = fRunFiles.find(run);
+  if( it == fRunFiles.end() )
+    it = fRunFiles.emplace(run, fFinder ? fFinder(run) : vector<string>()).first;
+  return it->second;
+}
+
+//_____________________________________________________________________________
+// Return up to 'n' of the most recent runs before 'run' that have files
+std::vector<Int_t> RunOverlayCache::FindPrevious( Int_t run, size_t n )
+{
+  vector<Int_t> runs;
+  for( Int_t r = run - 1; r > 0 && r >= run - kMaxRunGap && runs.size() < n;
+       --r ) {
+    if( !GetRunFiles(r).empty() )
+      runs.push_back(r);
+  }
+  return runs;
+}
+
+//_____________________________________________________________________________
+// Read histogram 'name' from 'files', summing it over the segments of runs
+// split into several files
+TH1* RunOverlayCache::Load( const vector<string>& files, const string& name )
+{
+  unique_ptr<TH1> sum;
+  for( const auto& file: files ) {
+    unique_ptr<TFile> f(TFile::Open(file.c_str(), "READ"));
+    if( !f || f->IsZombie() )
+      continue;
+    auto* h = f->Get<TH1>(name.c_str());
+    if( !h )
+      continue;
+    if( !sum ) {
+      TDirectory::TContext ctx(nullptr);  // Not owned by any directory
+      sum.reset(static_cast<TH1*>(h->Clone()));
+    } else {
+      sum->Add(h);
+    }
+  }
+  return sum.release();
+}
+
+//_____________________________________________________________________________
+// Return histogram 'name' of 'run', reading it if it is not cached. Returns
+// nullptr if the run or histogram is not found (which is cached as well).
+// The histogram remains owned by the cache.
+TH1* RunOverlayCache::Get( Int_t run, const string& name )
+{
+  Key_t key{run, name};
+  auto it = fIndex.find(key);
+  if( it != fIndex.end() ) {
+    fItems.splice(fItems.begin(), fItems, it->second);
+    return fItems.front().second.get();
+  }
+  unique_ptr<TH1> hist(Load(GetRunFiles(run), name));
+  if( !hist )
+    cerr << "Warning: cannot find " << name << " for run " << run << endl;
+  fItems.emplace_front(key, std::move(hist));
+  fIndex[key] = fItems.begin();
+  while( fItems.size() > fCapacity ) {
+    fIndex.erase(fItems.back().first);
+    fItems.pop_back();
+  }
+  return fItems.front().second.get();
+}
+
+//_____________________________________________________________________________
+void RunOverlayCache::Clear()
+{
+  fIndex.clear();
+  fItems.clear();
+  fRunFiles.clear();
+}
@@ -0,0 +1,81 @@
+///////////////////////////////////////////////////////////////////
+//  Cached pad contents
+///////////////////////////////////////////////////////////////////
+
+#include "panguinPadCache.hh"
+#include <TDirectory.h>
+#include <TList.h>
+#include <TH1.h>
+#include <TFrame.h>
+#include <TPaveText.h>
+#include <cstring>
+
+using namespace std;
+
+//_____________________________________________________________________________
+// Replace the cached contents of 'key' with copies of what is drawn in 'pad'
+void PadCache::Save( const string& key, TVirtualPad* pad )
+{
+  if( !pad )
+    return;
+  Contents contents;
+  TDirectory::TContext ctx(nullptr);  // Copies not attached to any file
+  TIter next(pad->GetListOfPrimitives());
+  while( auto* obj = next() ) {
+    if( dynamic_cast<TFrame*>(obj) ||
+        (dynamic_cast<TPaveText*>(obj) && strcmp(obj->GetName(), "title") == 0) ||
+        strcmp(obj->GetName(), "panguin_note") == 0 )
+      continue;
+    TObject* copy = obj->Clone();
+    if( auto* h = dynamic_cast<TH1*>(copy) )
+      h->SetDirectory(nullptr);
+    contents.items.push_back({unique_ptr<TObject>(copy), next.GetOption()});
+  }
+  contents.logx = pad->GetLogx();
+  contents.logy = pad->GetLogy();
+  contents.logz = pad->GetLogz();
+  contents.gridx = pad->GetGridx();
+  contents.gridy = pad->GetGridy();
+  contents.margin[0] = pad->GetLeftMargin();
+  contents.margin[1] = pad->GetRightMargin();
+  contents.margin[2] = pad->GetBottomMargin();
+  contents.margin[3] = pad->GetTopMargin();
+  contents.time = time(nullptr);
+  fPads[key] = std::move(contents);
+}
+
+//_____________________________________________________________________________
+// Time when the contents of 'key' were saved (0 if none)
+time_t PadCache::GetTime( const string& key ) const
+{
+  auto it = fPads.find(key);
+  return (it != fPads.end()) ? it->second.time : 0;
+}
+
+//_____________________________________________________________________________
+// Draw copies of the cached contents of 'key' in 'pad'. Returns false if
+// nothing is cached.
+bool PadCache::Restore( const string& key, TVirtualPad* pad ) const
+{
+  auto it = fPads.find(key);
+  if( it == fPads.end() || !pad )
+    return false;
+  const auto& contents = it->second;
+  pad->cd();
+  pad->SetLogx(contents.logx);
+  pad->SetLogy(contents.logy);
+  pad->SetLogz(contents.logz);
+  pad->SetGrid(contents.gridx, contents.gridy);
+  pad->SetMargin(contents.margin[0], contents.margin[1],
+                 contents.margin[2], contents.margin[3]);
+  TDirectory::TContext ctx(nullptr);
+  for( const auto& item: contents.items ) {
+    TObject* copy = item.obj->Clone();
+    if( auto* h = dynamic_cast<TH1*>(copy) )
+      h->SetDirectory(nullptr);
+    copy->SetBit(TObject::kCanDelete);
+    copy->Draw(item.option.c_str());
+  }
+  pad->Modified();
+  return true;
+}
@@ -0,0 +1,119 @@
+///////////////////////////////////////////////////////////////////
+//  Parallel filling of tree draw histograms
+///////////////////////////////////////////////////////////////////
+
+#include "panguinParallel.hh"
+#include "panguinFastFill.hh"
+#include "panguinSegments.hh"  // ParallelFor
+#include <TFile.h>
+#include <TMemFile.h>
+#include <TDirectory.h>
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+using namespace std;
+
+// Entries per part. Fixed, so that the result does not depend on the
+// number of threads.
+static const Long64_t kPartEntries = 500000;
+
+//_____________________________________________________________________________
+// Parallel filling needs a plain tree in a file that the workers can open
+// themselves. Otherwise all parts are filled from 'tree' in turn.
+ParallelTreeFill::ParallelTreeFill( TTree* tree, const TString& varexp,
+                                    const TString& cut, unsigned nthreads,
+                                    FormulaCache* formulas )
+  : fTree{tree}, fVarexp{varexp}, fCut{cut}, fNthreads{nthreads},
+    fFormulas{formulas}
+{
+  if( !tree || nthreads < 2 || tree->InheritsFrom("TChain") )
+    return;
+  TDirectory* dir = tree->GetDirectory();
+  TFile* file = dir ? dir->GetFile() : nullptr;
+  if( !file || dynamic_cast<TMemFile*>(file) )
+    return;
+  // Path of the directory within the file follows "file.root:/"
+  string path = dir->GetPath();
+  size_t pos = path.find(":/");
+  if( pos == string::npos )
+    return;
+  path = path.substr(pos + 2);
+  if( !path.empty() )
+    path += "/";
+  fTreePath = path + tree->GetName();
+  fFile = file->GetName();
+}
+
+//_____________________________________________________________________________
+// Fill 'n' entries of 'tree' starting at 'first' into 'hist'. Returns the
+// number of selected entries, or -1 on error.
+Long64_t ParallelTreeFill::FillPart( TTree* tree, TH1* hist, Long64_t first,
+                                     Long64_t n, FormulaCache* formulas ) const
+{
+  if( FastTreeFill::IsSimple(fVarexp, fCut) ) {
+    FastTreeFill fast(tree, fVarexp, fCut);
+    if( fast.IsValid() ) {
+      Long64_t nsel = fast.Fill(hist, first, n);
+      if( nsel >= 0 )
+        return nsel;
+    }
+  }
+  if( formulas ) {
+    TreeExpr* expr = formulas->Get(tree, fVarexp, fCut);
+    return expr ? expr->Fill(hist, first, n) : -1;
+  }
+  TreeExpr expr(tree, fVarexp, fCut);
+  return expr.Fill(hist, first, n);
+}
+
+//_____________________________________________________________________________
+// Add 'n' entries starting at 'first' to 'hist', which must have fixed
+// binning. Returns the number of selected entries, or -1 on error, in which
+// case 'hist' is unchanged.
+Long64_t ParallelTreeFill::Fill( TH1* hist, Long64_t first, Long64_t n )
+{
+  if( !fTree || !hist )
+    return -1;
+  n = min(n, fTree->GetEntries() - first);
+  if( n <= 0 )
+    return 0;
+  size_t nparts = static_cast<size_t>((n + kPartEntries - 1) / kPartEntries);
+  bool parallel = !fFile.empty() && nparts > 1;
+
+  // Empty copies of 'hist', made here rather than in the workers
+  vector<unique_ptr<TH1>> parts(nparts);
+  {
+    TDirectory::TContext ctx(nullptr);
+    for( auto& part: parts ) {
+      part.reset(static_cast<TH1*>(hist->Clone()));
+      part->SetDirectory(nullptr);
+      part->Reset();
+    }
+  }
+  vector<Long64_t> nsel(nparts, -1);
+  ParallelFor(nparts, parallel ? fNthreads : 1, [&]( size_t k ) {
+    Long64_t start = first + static_cast<Long64_t>(k) * kPartEntries;
+    Long64_t len = min(kPartEntries, first + n - start);
+    if( !parallel ) {
+      nsel[k] = FillPart(fTree, parts[k].get(), start, len, fFormulas);
+      return;
+    }
+    TDirectory::TContext ctx(nullptr);
+    unique_ptr<TFile> file(TFile::Open(fFile.c_str(), "READ"));
+    TTree* tree = (file && !file->IsZombie())
+                  ? dynamic_cast<TTree*>(file->Get(fTreePath.c_str())) : nullptr;
+    if( tree )
+      nsel[k] = FillPart(tree, parts[k].get(), start, len, nullptr);
+  });
+
+  Long64_t total = 0;
+  for( auto ns: nsel ) {
+    if( ns < 0 )
+      return -1;
+    total += ns;
+  }
+  for( auto& part: parts )
+    hist->Add(part.get());
+  return total;
+}
@@ -0,0 +1,85 @@
+///////////////////////////////////////////////////////////////////
+//  Shared libraries and compiled draw plugins
+///////////////////////////////////////////////////////////////////
+
+#include "panguinPlugins.hh"
+#include <TSystem.h>
+#include <cctype>
+#include <iostream>
+
+using namespace std;
+
+//_____________________________________________________________________________
+// Load shared library 'lib' unless done before. Returns false if loading
+// failed, now or before.
+bool LibraryRegistry::Load( const string& lib )
+{
+  auto it = fLibs.find(lib);
+  if( it != fLibs.end() )
+    return it->second.error.empty();
+  Library& l = fLibs[lib];
+  switch( gSystem->Load(lib.c_str()) ) {
+    case 0:
+    case 1:
+      break;
+    case -2:
+      l.error = "version mismatch";
+      break;
+    case -3:
+      l.error = "static initialization failed";
+      break;
+    default:
+      l.error = "not found or cannot be loaded";
+      break;
+  }
+  if( !l.error.empty() ) {
+    l.error = "Cannot load " + lib + ": " + l.error;
+    cerr << "Error: " << l.error << endl;
+  }
+  return l.error.empty();
+}
+
+//_____________________________________________________________________________
+// Draw function 'name' defined with PANGUIN_DRAW in library 'lib', which is
+// loaded if needed. Returns nullptr if the library cannot be loaded or does
+// not define such a function.
+PanguinDraw_t LibraryRegistry::FindDraw( const string& lib, const string& name )
+{
+  if( !Load(lib) )
+    return nullptr;
+  Library& l = fLibs[lib];
+  auto it = l.draws.find(name);
+  if( it != l.draws.end() )
+    return it->second;
+  string sym = "panguin_draw_" + name;
+  auto fn = reinterpret_cast<PanguinDraw_t>(
+    gSystem->DynFindSymbol(lib.c_str(), sym.c_str()));
+  l.draws[name] = fn;
+  return fn;
+}
+
+//_____________________________________________________________________________
+const string& LibraryRegistry::GetError( const string& lib ) const
+{
+  static const string none;
+  auto it = fLibs.find(lib);
+  return (it != fLibs.end()) ? it->second.error : none;
+}
+
+//_____________________________________________________________________________
+bool SplitMacroCall( const string& call, string& name, string& args )
+{
+  size_t i = 0;
+  while( i < call.size() && (isalnum(call[i]) || call[i] == '_') )
+    ++i;
+  if( i == 0 || isdigit(call[0]) )
+    return false;
+  name = call.substr(0, i);
+  args.clear();
+  if( i == call.size() )
+    return true;
+  if( call[i] != '(' || call.back() != ')' )
+    return false;
+  args = call.substr(i + 1, call.size() - i - 2);
+  return true;
+}
@@ -0,0 +1,90 @@
+///////////////////////////////////////////////////////////////////
+//  Parallel reading of objects from a ROOT file
+///////////////////////////////////////////////////////////////////
+
+#include "panguinPreload.hh"
+#include "panguinSegments.hh"  // ParallelFor
+#include <TKey.h>
+#include <TH1.h>
+#include <TDirectory.h>
+#include <TSystem.h>
+#include <algorithm>
+
+using namespace std;
+
+//_____________________________________________________________________________
+// Read object 'name' ("dir/name") of 'file' from its key, detached from
+// the file so that it survives closing it
+static TObject* ReadDetached( TFile* file, const string& name )
+{
+  TDirectory* dir = file;
+  string base = name;
+  size_t slash = name.rfind('/');
+  if( slash != string::npos ) {
+    dir = file->GetDirectory(name.substr(0, slash).c_str());
+    base = name.substr(slash + 1);
+  }
+  TKey* key = dir ? dir->GetKey(base.c_str()) : nullptr;
+  TObject* obj = key ? key->ReadObj() : nullptr;
+  if( auto* h = dynamic_cast<TH1*>(obj) )
+    h->SetDirectory(nullptr);
+  return obj;
+}
+
+//_____________________________________________________________________________
+ParallelReader::ParallelReader( string file, unsigned nthreads )
+  : fFile{std::move(file)}
+  , fFileId{GetFileId(fFile)}
+  , fNthreads{max(nthreads, 1u)}
+  , fHandles(fNthreads)
+{
+}
+
+//_____________________________________________________________________________
+// Device and inode of 'file', which identify it even if a new file of the
+// same name replaces it. (0,0) if it does not exist.
+pair<Long_t, Long_t> ParallelReader::GetFileId( const string& file )
+{
+  FileStat_t st;
+  if( gSystem->GetPathInfo(file.c_str(), st) != 0 )
+    return {0, 0};
+  return {st.fDev, st.fIno};
+}
+
+//_____________________________________________________________________________
+// True if the handles are of 'file', and it has not been replaced by a new
+// file of the same name (e.g. for the next run) since they were opened
+bool ParallelReader::IsFile( const string& file ) const
+{
+  return file == fFile && GetFileId(file) == fFileId;
+}
+
+//_____________________________________________________________________________
+ParallelReader::~ParallelReader()
+{
+  TDirectory::TContext ctx(nullptr);
+  fHandles.clear();
+}
+
+//_____________________________________________________________________________
+vector<unique_ptr<TObject>> ParallelReader::Read( const vector<string>& names )
+{
+  vector<unique_ptr<TObject>> objs(names.size());
+  size_t nworkers = min<size_t>(fNthreads, names.size());
+  // Worker k uses handle k, opening it the first time, and reads every
+  // nworkers-th object. Handles opened before reread the keys, which the
+  // writer of the file may have added to.
+  ParallelFor(nworkers, static_cast<unsigned>(nworkers), [&]( size_t k ) {
+    TDirectory::TContext ctx(nullptr);
+    auto& f = fHandles[k];
+    if( f && !f->IsZombie() )
+      f->ReadKeys();
+    else
+      f.reset(TFile::Open(fFile.c_str(), "READ"));
+    if( !f || f->IsZombie() )
+      return;
+    for( size_t i = k; i < names.size(); i += nworkers )
+      objs[i].reset(ReadDetached(f.get(), names[i]));
+  });
+  return objs;
+}
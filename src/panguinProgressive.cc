@@ -0,0 +1,151 @@
+///////////////////////////////////////////////////////////////////
+//  Progressive filling of tree-draw histograms
+///////////////////////////////////////////////////////////////////
+
+#include "panguinProgressive.hh"
+#include "panguinBudget.hh"  // Elapsed
+#include <TROOT.h>
+#include <TDirectory.h>
+#include <TStopwatch.h>
+#include <algorithm>
+
+using namespace std;
+
+// Number of blocks the sample is divided into
+static const Long64_t kBlocks = 16;
+// Smallest number of entries processed per Step()
+static const Long64_t kMinChunk = 1000;
+
+//_____________________________________________________________________________
+ProgressiveFill::ProgressiveFill( TTree* tree, TString varexp, TCut cut,
+                                  Double_t fraction, FormulaCache* formulas )
+  : fTree{tree}
+  , fVarexp{std::move(varexp)}
+  , fCut{std::move(cut)}
+  , fFraction{fraction}
+  , fFormulas{formulas}
+{
+}
+
+//_____________________________________________________________________________
+// Add the entries in 'range' to the histogram. Uses the compiled expression
+// from the formula cache if possible, which saves parsing it for each chunk.
+Long64_t ProgressiveFill::Fill( const Range_t& range, const char* option )
+{
+  TreeExpr* expr = fFormulas ? fFormulas->Get(fTree, fVarexp, fCut.GetTitle())
+                             : nullptr;
+  if( expr ) {
+    Long64_t nsel = expr->Fill(fHist, range.first, range.second);
+    if( nsel >= 0 )
+      return nsel;
+  }
+  TDirectory::TContext ctx(fHist->GetDirectory());
+  return fTree->Draw(fVarexp + ">>+" + fHist->GetName(), fCut, option,
+                     range.second, range.first);
+}
+
+//_____________________________________________________________________________
+// Draw the sample into a new histogram 'hname' in the current pad. Returns
+// the number of selected entries, like TTree::Draw. The entries outside of
+// the sample are left for Step(). If 'maxtime' (seconds) is > 0, filling
+// stops after the first sample block that ends past this time, and the
+// remaining blocks are left for Step() as well.
+Long64_t ProgressiveFill::DrawSample( const TString& hname,
+                                      const TString& drawopt,
+                                      Double_t maxtime )
+{
+  fTotal = fTree->GetEntries();
+  Long64_t blocksize = max(static_cast<Long64_t>(fTotal * fFraction) / kBlocks,
+                           Long64_t(1));
+  vector<Range_t> sample;
+  fPending.clear();
+  Long64_t pos = 0;
+  for( Long64_t i = 0; i < kBlocks && pos < fTotal; ++i ) {
+    Long64_t start = max(i * fTotal / kBlocks, pos);
+    if( start > pos )
+      fPending.emplace_back(pos, start - pos);
+    Long64_t n = min(blocksize, fTotal - start);
+    sample.emplace_back(start, n);
+    pos = start + n;
+  }
+  if( pos < fTotal )
+    fPending.emplace_back(pos, fTotal - pos);
+  if( sample.empty() )
+    return 0;
+
+  TStopwatch timer;
+  fPad = gPad;
+  Long64_t nsel = fTree->Draw(fVarexp + ">>" + hname, fCut, drawopt,
+                              sample[0].second, sample[0].first);
+  fHist = dynamic_cast<TH1*>(gROOT->FindObject(hname));
+  if( nsel < 0 || !fHist ) {
+    // Error, or no histogram (e.g. graph). Draw everything at once
+    fPending.clear();
+    fHist = nullptr;
+    return nsel < 0 ? nsel : fTree->Draw(fVarexp, fCut, drawopt);
+  }
+  fDone = sample[0].second;
+  for( size_t i = 1; i < sample.size(); ++i ) {
+    if( maxtime > 0 && Elapsed(timer) > maxtime ) {
+      fPending.insert(fPending.end(), sample.begin() + i, sample.end());
+      break;
+    }
+    nsel += Fill(sample[i], "goff");
+    fDone += sample[i].second;
+  }
+  Double_t t = timer.RealTime();
+  fRate = t > 0 ? fDone / t : 0;
+  UpdateTitle();
+  return nsel;
+}
+
+//_____________________________________________________________________________
+// Add the next pending entries to the histogram, as many as can be done in
+// about 'seconds'. Returns true if entries remain to be done.
+bool ProgressiveFill::Step( Double_t seconds )
+{
+  if( !fHist || IsDone() )
+    return false;
+  Long64_t nmax = max(static_cast<Long64_t>(fRate * seconds), kMinChunk);
+  Long64_t ndone = 0;
+  TStopwatch timer;
+  while( ndone < nmax && !fPending.empty() ) {
+    auto& range = fPending.front();
+    Long64_t n = min(nmax - ndone, range.second);
+    Fill(Range_t(range.first, n), "goff");
+    range.first += n;
+    range.second -= n;
+    ndone += n;
+    if( range.second == 0 )
+      fPending.erase(fPending.begin());
+  }
+  fDone += ndone;
+  Double_t t = timer.RealTime();
+  if( t > 0 )
+    fRate = ndone / t;
+  UpdateTitle();
+  return !IsDone();
+}
+
+//_____________________________________________________________________________
+// Fraction of entries processed so far
+Double_t ProgressiveFill::GetFraction() const
+{
+  return fTotal > 0 ? static_cast<Double_t>(fDone) / fTotal : 1.0;
+}
+
+//_____________________________________________________________________________
+// Show the fraction of entries processed in the histogram title, or remove
+// it when done. Keeps any title change made since the last call.
+void ProgressiveFill::UpdateTitle()
+{
+  if( !fHist )
+    return;
+  TString title = fHist->GetTitle();
+  if( !fSuffix.IsNull() && title.EndsWith(fSuffix) )
+    title.Remove(title.Length() - fSuffix.Length());
+  fSuffix = IsDone() ? TString()
+                     : TString::Format(" [%.3g%% of entries]",
+                                       100 * GetFraction());
+  fHist->SetTitle(title + fSuffix);
+}
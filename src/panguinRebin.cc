@@ -0,0 +1,215 @@
+///////////////////////////////////////////////////////////////////
+//  Display-resolution copies of large 2D histograms
+///////////////////////////////////////////////////////////////////
+
+#include "panguinRebin.hh"
+#include <TH2D.h>
+#include <TAxis.h>
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+//_____________________________________________________________________________
+// Return the histogram to draw for 'src' in a pad of npx x npy pixels:
+// either 'src' itself, if it is small enough, or the cached display copy,
+// rebuilt if necessary.
+TH2* DisplayRebin::Get( TH2* src, Int_t npx, Int_t npy )
+{
+  if( !src || npx <= 0 || npy <= 0 )
+    return src;
+  const TAxis* ax = src->GetXaxis();
+  const TAxis* ay = src->GetYaxis();
+  // Bin contents of profiles and polygon bins can't simply be summed.
+  // Labeled bins must all be shown.
+  if( (ax->GetNbins() < 2 * npx && ay->GetNbins() < 2 * npy) ||
+      src->InheritsFrom("TProfile2D") || src->InheritsFrom("TH2Poly") ||
+      ax->GetLabels() || ay->GetLabels() ) {
+    Clear();
+    return src;
+  }
+  if( IsUnchanged(src) && npx == fNpx && npy == fNpy ) {
+    // Unchanged unless the user zoomed
+    const TAxis* dx = fDisplay->GetXaxis();
+    const TAxis* dy = fDisplay->GetYaxis();
+    if( dx->GetBinLowEdge(dx->GetFirst()) == fXlo &&
+        dx->GetBinUpEdge(dx->GetLast()) == fXhi &&
+        dy->GetBinLowEdge(dy->GetFirst()) == fYlo &&
+        dy->GetBinUpEdge(dy->GetLast()) == fYhi )
+      return fDisplay.get();
+  }
+  Build(src, npx, npy);
+  return fDisplay.get();
+}
+
+//_____________________________________________________________________________
+// True if the display copy is of 'src': same name and binning. The zoom
+// of the copy can then be carried over.
+bool DisplayRebin::IsSource( const TH2* src ) const
+{
+  return fDisplay && fSource == src->GetName() && GetBinning(src) == fBinning;
+}
+
+//_____________________________________________________________________________
+// Number of bins and range of both axes of 'src'
+vector<Double_t> DisplayRebin::GetBinning( const TH2* src )
+{
+  const TAxis* ax = src->GetXaxis();
+  const TAxis* ay = src->GetYaxis();
+  return {static_cast<Double_t>(ax->GetNbins()), ax->GetXmin(), ax->GetXmax(),
+          static_cast<Double_t>(ay->GetNbins()), ay->GetXmin(), ay->GetXmax()};
+}
+
+//_____________________________________________________________________________
+// True if the display copy is of 'src' and 'src' has not changed since
+// the copy was built, judged by its number of entries and statistics
+bool DisplayRebin::IsUnchanged( const TH2* src ) const
+{
+  if( !IsSource(src) || src->GetEntries() != fEntries )
+    return false;
+  vector<Double_t> stats(TH1::kNstat);
+  src->GetStats(stats.data());
+  return stats == fStats;
+}
+
+//_____________________________________________________________________________
+// Group the bins of axis 'ax' for display. Bins first..last are grouped so
+// that there are between npix and 2*npix groups; bins outside this range
+// are grouped as coarsely as the full axis would be. On return, 'map' gives
+// the display bin for each source bin (including under/overflow), and
+// 'edges' contains the display bin edges.
+void DisplayRebin::MakeGroups( const TAxis* ax, Int_t first, Int_t last,
+                               Int_t npix, vector<Int_t>& map,
+                               vector<Double_t>& edges )
+{
+  Int_t n = ax->GetNbins();
+  map.assign(n + 2, 0);
+  edges.clear();
+  Int_t gin = max(1, (last - first + 1) / npix);
+  Int_t gout = max(1, n / npix);
+  Int_t nd = 0;
+  auto group = [&]( Int_t lo, Int_t hi, Int_t g ) {
+    for( Int_t b = lo; b <= hi; b += g ) {
+      edges.push_back(ax->GetBinLowEdge(b));
+      ++nd;
+      for( Int_t k = b; k <= min(b + g - 1, hi); ++k )
+        map[k] = nd;
+    }
+  };
+  group(1, first - 1, gout);
+  group(first, last, gin);
+  group(last + 1, n, gout);
+  edges.push_back(ax->GetBinUpEdge(n));
+  map[n + 1] = nd + 1;
+}
+
+//_____________________________________________________________________________
+void DisplayRebin::Build( const TH2* src, Int_t npx, Int_t npy )
+{
+  const TAxis* ax = src->GetXaxis();
+  const TAxis* ay = src->GetYaxis();
+  Int_t fx = ax->GetFirst(), lx = ax->GetLast();
+  Int_t fy = ay->GetFirst(), ly = ay->GetLast();
+  if( IsSource(src) ) {
+    // Carry over the zoom of the previous copy. Its bin edges are edges of
+    // the source bins.
+    const TAxis* dx = fDisplay->GetXaxis();
+    const TAxis* dy = fDisplay->GetYaxis();
+    fx = ax->FindFixBin(dx->GetBinLowEdge(dx->GetFirst()));
+    lx = ax->FindFixBin(dx->GetBinUpEdge(dx->GetLast())) - 1;
+    fy = ay->FindFixBin(dy->GetBinLowEdge(dy->GetFirst()));
+    ly = ay->FindFixBin(dy->GetBinUpEdge(dy->GetLast())) - 1;
+    fx = max(fx, 1); lx = min(lx, ax->GetNbins());
+    fy = max(fy, 1); ly = min(ly, ay->GetNbins());
+    if( lx < fx ) { fx = 1; lx = ax->GetNbins(); }
+    if( ly < fy ) { fy = 1; ly = ay->GetNbins(); }
+  }
+
+  vector<Int_t> mapx, mapy;
+  vector<Double_t> ex, ey;
+  MakeGroups(ax, fx, lx, npx, mapx, ex);
+  MakeGroups(ay, fy, ly, npy, mapy, ey);
+  auto nx = static_cast<Int_t>(ex.size()) - 1;
+  auto ny = static_cast<Int_t>(ey.size()) - 1;
+
+  unique_ptr<TH2> disp(new TH2D(Form("%s_display", src->GetName()),
+                                src->GetTitle(), nx, ex.data(), ny, ey.data()));
+  disp->SetDirectory(nullptr);
+
+  // Sum the source bins into the display bins
+  bool errors = src->GetSumw2N() > 0;
+  const Int_t ncx = ax->GetNbins() + 2, ncy = ay->GetNbins() + 2;
+  const size_t ndx = nx + 2;
+  vector<Double_t> val(ndx * (ny + 2)), err2;
+  if( errors )
+    err2.resize(val.size());
+  for( Int_t iy = 0; iy < ncy; ++iy ) {
+    size_t row = ndx * mapy[iy];
+    for( Int_t ix = 0; ix < ncx; ++ix ) {
+      Int_t bin = iy * ncx + ix;
+      size_t dest = row + mapx[ix];
+      val[dest] += src->GetBinContent(bin);
+      if( errors ) {
+        Double_t e = src->GetBinError(bin);
+        err2[dest] += e * e;
+      }
+    }
+  }
+  disp->SetContent(val.data());
+  if( errors ) {
+    disp->Sumw2();
+    for( auto& e: err2 )
+      e = sqrt(e);
+    disp->SetError(err2.data());
+  }
+  // Statistics are those of the full-resolution histogram
+  Double_t stats[TH1::kNstat];
+  src->GetStats(stats);
+  disp->PutStats(stats);
+  disp->SetEntries(src->GetEntries());
+
+  // Appearance
+  src->TAttLine::Copy(*disp);
+  src->TAttFill::Copy(*disp);
+  src->TAttMarker::Copy(*disp);
+  ax->TAttAxis::Copy(*disp->GetXaxis());
+  ay->TAttAxis::Copy(*disp->GetYaxis());
+  src->GetZaxis()->TAttAxis::Copy(*disp->GetZaxis());
+  disp->GetXaxis()->SetTitle(ax->GetTitle());
+  disp->GetYaxis()->SetTitle(ay->GetTitle());
+  disp->GetZaxis()->SetTitle(src->GetZaxis()->GetTitle());
+  disp->SetStats(!src->TestBit(TH1::kNoStats));
+  if( src->GetMinimumStored() != -1111 )
+    disp->SetMinimum(src->GetMinimumStored());
+  if( src->GetMaximumStored() != -1111 )
+    disp->SetMaximum(src->GetMaximumStored());
+
+  if( fx > 1 || lx < ax->GetNbins() )
+    disp->GetXaxis()->SetRange(mapx[fx], mapx[lx]);
+  if( fy > 1 || ly < ay->GetNbins() )
+    disp->GetYaxis()->SetRange(mapy[fy], mapy[ly]);
+
+  fDisplay = std::move(disp);
+  const TAxis* dx = fDisplay->GetXaxis();
+  const TAxis* dy = fDisplay->GetYaxis();
+  fXlo = dx->GetBinLowEdge(dx->GetFirst());
+  fXhi = dx->GetBinUpEdge(dx->GetLast());
+  fYlo = dy->GetBinLowEdge(dy->GetFirst());
+  fYhi = dy->GetBinUpEdge(dy->GetLast());
+  fSource = src->GetName();
+  fBinning = GetBinning(src);
+  fEntries = src->GetEntries();
+  fStats.assign(stats, stats + TH1::kNstat);
+  fNpx = npx;
+  fNpy = npy;
+}
+
+//_____________________________________________________________________________
+void DisplayRebin::Clear()
+{
+  fDisplay.reset();
+  fSource = "";
+  fEntries = -1;
+  fBinning.clear();
+  fStats.clear();
+}
@@ -0,0 +1,30 @@
+///////////////////////////////////////////////////////////////////
+//  Refresh cadence of pads in monitor mode
+///////////////////////////////////////////////////////////////////
+
+#include "panguinSchedule.hh"
+
+using namespace std;
+
+//_____________________________________________________________________________
+// Returns true if pad 'key' should be recomputed now, and if so, sets its
+// next deadline. 'every' is the number of monitor updates between
+// recomputations, 'interval' the time between them (ms), 'now' the current
+// time (ms); either may be 0 if not used. 'tick' is true if this draw is a
+// monitor update. Pads seen for the first time are always due.
+bool RefreshSchedule::IsDue( const string& key, int every, long long interval,
+                             long long now, bool tick )
+{
+  auto ins = fPads.emplace(key, Deadline());
+  auto& pad = ins.first->second;
+  if( tick )
+    pad.ticks++;
+  bool due = ins.second ||
+             (every > 0 && pad.ticks >= every) ||
+             (interval > 0 && now >= pad.next);
+  if( due ) {
+    pad.ticks = 0;
+    pad.next = now + interval;
+  }
+  return due;
+}
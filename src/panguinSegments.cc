@@ -0,0 +1,294 @@
+///////////////////////////////////////////////////////////////////
+//  Runs split into several ROOT files ("segments")
+///////////////////////////////////////////////////////////////////
+
+#include "panguinSegments.hh"
+#include "panguinBinning.hh"
+#include <RConfigure.h>  // R__USE_IMT
+#include <TMemFile.h>
+#include <TKey.h>
+#include <TClass.h>
+#include <TList.h>
+#ifdef R__USE_IMT
+#include <ROOT/TThreadExecutor.hxx>
+#include <ROOT/TSeq.hxx>
+#endif
+#include <iostream>
+#include <map>
+#include <thread>
+#include <algorithm>
+
+using namespace std;
+
+//_____________________________________________________________________________
+void ParallelFor( size_t n, unsigned nthreads,
+                  const function<void(size_t)>& func )
+{
+#ifdef R__USE_IMT
+  if( nthreads > 1 && n > 1 ) {
+    ROOT::EnableThreadSafety();
+    ROOT::TThreadExecutor pool(static_cast<unsigned>(min<size_t>(nthreads, n)));
+    pool.Foreach([&]( unsigned i ) { func(i); },
+                 ROOT::TSeqU(static_cast<unsigned>(n)));
+    return;
+  }
+#endif
+  for( size_t i = 0; i < n; ++i )
+    func(i);
+}
+
+//_____________________________________________________________________________
+// Number of dimensions of a TTree::Draw expression ("y:x" -> 2), ignoring
+// scope operators like TMath::Abs
+static int CountDimensions( const TString& expr )
+{
+  int ndim = 1;
+  for( Ssiz_t i = 0; i < expr.Length(); ++i ) {
+    if( expr[i] == ':' ) {
+      if( i + 1 < expr.Length() && expr[i+1] == ':' )
+        ++i;
+      else
+        ++ndim;
+    }
+  }
+  return ndim;
+}
+
+//_____________________________________________________________________________
+struct SegmentedRun::Segment {
+  map<string, unique_ptr<TH1>> hists;  // Histograms by path
+  set<string>                  trees;  // Paths of trees
+};
+
+//_____________________________________________________________________________
+SegmentedRun::SegmentedRun( unsigned nthreads )
+  : fNthreads{nthreads > 0 ? nthreads : thread::hardware_concurrency()}
+{
+  if( fNthreads == 0 )
+    fNthreads = 1;
+}
+
+//_____________________________________________________________________________
+SegmentedRun::~SegmentedRun()
+{
+  Clear();
+}
+
+//_____________________________________________________________________________
+// Restrict the histograms read from the files to the given paths. Skipping
+// histograms that are never drawn saves both I/O and merging time.
+void SegmentedRun::SetSelection( const vector<string>& names )
+{
+  fSelection.clear();
+  fSelection.insert(names.begin(), names.end());
+}
+
+//_____________________________________________________________________________
+void SegmentedRun::ReadDirectory( TDirectory* dir, const string& path, // NOLINT(*-no-recursion)
+                                  Segment& seg ) const
+{
+  TIter next(dir->GetListOfKeys());
+  while( auto* key = static_cast<TKey*>(next()) ) {
+    string name = path.empty() ? key->GetName() : path + "/" + key->GetName();
+    TClass* cl = TClass::GetClass(key->GetClassName());
+    if( !cl )
+      continue;
+    if( cl->InheritsFrom(TDirectory::Class()) ) {
+      if( auto* subdir = dir->GetDirectory(key->GetName()) )
+        ReadDirectory(subdir, name, seg);
+    } else if( cl->InheritsFrom(TTree::Class()) ) {
+      seg.trees.insert(name);
+    } else if( cl->InheritsFrom(TH1::Class()) && !seg.hists.count(name) &&
+               (fSelection.empty() || fSelection.count(name)) ) {
+      // Keys are sorted by cycle, highest first, so older cycles are skipped
+      unique_ptr<TH1> h(key->ReadObject<TH1>());
+      if( h ) {
+        h->SetDirectory(nullptr);
+        seg.hists[name] = std::move(h);
+      }
+    }
+  }
+}
+
+//_____________________________________________________________________________
+void SegmentedRun::ReadSegment( const string& file, Segment& seg ) const
+{
+  unique_ptr<TFile> f(TFile::Open(file.c_str(), "READ"));
+  if( !f || f->IsZombie() ) {
+    cerr << "Error opening segment " << file << ", skipped" << endl;
+    return;
+  }
+  ReadDirectory(f.get(), "", seg);
+}
+
+//_____________________________________________________________________________
+// Add the contents of 'from' to 'to'. 'from' is left empty.
+void SegmentedRun::MergeSegments( Segment& to, Segment& from )
+{
+  for( auto& item: from.hists ) {
+    auto it = to.hists.find(item.first);
+    if( it == to.hists.end() ) {
+      to.hists.emplace(item.first, std::move(item.second));
+    } else {
+      TList list;
+      list.Add(item.second.get());
+      it->second->Merge(&list);
+    }
+  }
+  to.trees.insert(from.trees.begin(), from.trees.end());
+  from.hists.clear();
+  from.trees.clear();
+}
+
+//_____________________________________________________________________________
+// Read and merge the given files. Returns an in-memory file with the
+// merged histograms, owned by the caller, or nullptr if there are no files.
+TFile* SegmentedRun::Open( const vector<string>& files )
+{
+  Clear();
+  fFiles = files;
+  size_t n = files.size();
+  if( n == 0 )
+    return nullptr;
+
+  // Each worker sums a fixed, contiguous range of files, so that at most
+  // one partial sum per worker is held in memory
+  size_t nparts = min<size_t>(n, fNthreads);
+  vector<Segment> parts(nparts);
+  ParallelFor(nparts, fNthreads, [&]( size_t k ) {
+    for( size_t i = k * n / nparts; i < (k + 1) * n / nparts; ++i ) {
+      Segment seg;
+      ReadSegment(files[i], seg);
+      MergeSegments(parts[k], seg);
+    }
+  });
+  // Pairwise tree reduction of the partial sums. The pairing is fixed, so
+  // the result does not depend on the scheduling of the threads.
+  for( size_t stride = 1; stride < nparts; stride *= 2 ) {
+    size_t npairs = (nparts + 2 * stride - 1) / (2 * stride);
+    ParallelFor(npairs, fNthreads, [&]( size_t k ) {
+      size_t i = 2 * stride * k, j = i + stride;
+      if( j < nparts )
+        MergeSegments(parts[i], parts[j]);
+    });
+  }
+  auto& merged = parts[0];
+
+  // Uncompressed, since it never leaves memory
+  auto* file = new TMemFile("panguin_segments.root", "RECREATE", "", 0);
+  for( auto& item: merged.hists ) {
+    const string& path = item.first;
+    TDirectory* dir = file;
+    auto pos = path.rfind('/');
+    if( pos != string::npos ) {
+      string dirname = path.substr(0, pos);
+      dir = file->GetDirectory(dirname.c_str());
+      if( !dir )
+        dir = file->mkdir(dirname.c_str());
+    }
+    TH1* h = item.second.release();
+    dir->WriteTObject(h, path.substr(pos + 1).c_str());
+    h->SetDirectory(dir);  // Found by Get() without reading the key back
+  }
+  for( const auto& path: merged.trees ) {
+    auto* chain = new TChain(path.c_str());
+    for( const auto& segfile: files )
+      chain->Add(segfile.c_str());
+    fChains.push_back(chain);
+  }
+  return file;
+}
+
+//_____________________________________________________________________________
+// Fill the histogram of a TTree::Draw of 1D or 2D expression 'varexp' for
+// one of our chains, processing the segments in parallel. The binning is
+// determined from the first entries of the chain, as with "fixbinning".
+// Each segment is filled into its own histogram with that binning, whose
+// axes are extended for values outside of it, and the histograms are
+// merged in segment order. No values are buffered, so the memory needed
+// does not depend on the number of entries. Returns nullptr if this is not
+// possible (other types of plots, too few segments, threads or entries);
+// 'nsel' is then -1 if the expression is invalid, 0 otherwise.
+unique_ptr<TH1> SegmentedRun::Draw( TTree* tree, const TString& varexp,
+                                    const TCut& cut, const TString& drawopt,
+                                    Long64_t& nsel ) const
+{
+  nsel = 0;
+  if( fFiles.size() < 2 || fNthreads < 2 ||
+      find(fChains.begin(), fChains.end(), tree) == fChains.end() )
+    return nullptr;
+  int ndim = CountDimensions(varexp);
+  TString opt = drawopt;
+  opt.ToLower();
+  // Scatter plots, profiles, overlays and user histograms go the usual way
+  if( ndim > 2 || varexp.Contains(">>") || opt.Contains("prof") ||
+      opt.Contains("same") || (ndim == 2 && opt.IsNull()) )
+    return nullptr;
+  Binning binning;
+  {
+    TreeExpr sample(tree, varexp, cut.GetTitle());
+    if( !sample.IsValid() )
+      return nullptr;  // TTree::Draw reports the error
+    binning = BinningResolver::FromSample(&sample);
+  }
+  if( !binning.IsValid() )
+    return nullptr;
+
+  TString title = varexp;
+  if( strlen(cut.GetTitle()) > 0 )
+    title += Form(" {%s}", cut.GetTitle());
+  size_t n = fFiles.size();
+  vector<unique_ptr<TH1>> parts(n);
+  vector<Long64_t> nsels(n, 0);
+  string treename = tree->GetName();
+  ParallelFor(n, fNthreads, [&]( size_t i ) {
+    TDirectory::TContext ctx(nullptr);
+    unique_ptr<TFile> f(TFile::Open(fFiles[i].c_str(), "READ"));
+    TTree* t = (f && !f->IsZombie()) ? f->Get<TTree>(treename.c_str()) : nullptr;
+    if( !t )
+      return;  // Missing segment contributes nothing
+    TreeExpr expr(t, varexp, cut.GetTitle());
+    if( !expr.IsValid() ) {
+      nsels[i] = -1;
+      return;
+    }
+    unique_ptr<TH1> h(binning.Book(Form("htemp_%zu", i), title));
+    h->SetCanExtend(TH1::kAllAxes);
+    nsels[i] = expr.Fill(h.get(), 0, t->GetEntries());
+    parts[i] = std::move(h);
+  });
+  unique_ptr<TH1> h;
+  TList others;
+  for( size_t i = 0; i < n; ++i ) {
+    if( nsels[i] < 0 ) {
+      nsel = -1;
+      return nullptr;
+    }
+    nsel += nsels[i];
+    if( !parts[i] )
+      continue;
+    if( h )
+      others.Add(parts[i].get());
+    else
+      h = std::move(parts[i]);
+  }
+  if( !h )
+    return nullptr;
+  if( others.GetSize() > 0 )
+    h->Merge(&others);
+  h->SetName("htemp");
+  auto vars = SplitVarexp(varexp);
+  h->GetXaxis()->SetTitle(vars.back().Strip(TString::kBoth));
+  if( ndim == 2 )
+    h->GetYaxis()->SetTitle(vars.front().Strip(TString::kBoth));
+  return h;
+}
+
+//_____________________________________________________________________________
+void SegmentedRun::Clear()
+{
+  for( auto* chain: fChains )
+    delete chain;
+  fChains.clear();
+  fFiles.clear();
+}
@@ -0,0 +1,108 @@
+///////////////////////////////////////////////////////////////////
+//  Page server for thin clients
+///////////////////////////////////////////////////////////////////
+
+#include "panguinServer.hh"
+#include <TCanvas.h>
+#include <TList.h>
+#include <TParameter.h>
+#include <TSystem.h>
+#include <iostream>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+//_____________________________________________________________________________
+PageServer::PageServer( Int_t port )
+  : fServer{new TServerSocket(port, true)}
+{
+  if( fServer->IsValid() )
+    fMonitor.Add(fServer.get());
+  else
+    cerr << "Cannot listen on port " << port << endl;
+}
+
+//_____________________________________________________________________________
+PageServer::~PageServer()
+{
+  for( auto* sock: fClients ) {
+    fMonitor.Remove(sock);
+    delete sock;
+  }
+}
+
+//_____________________________________________________________________________
+// Serialize 'canvas' as the current state of page 'page' (0, 1, ...)
+void PageServer::SetPage( Int_t page, TCanvas* canvas, Int_t run,
+                          time_t updated )
+{
+  if( page < 0 )
+    return;
+  if( page >= static_cast<Int_t>(fPages.size()) )
+    fPages.resize(page + 1);
+  TParameter<Long64_t> prun("run", run), pupdated("updated", updated);
+  TList reply;  // Not owner
+  reply.Add(canvas);
+  reply.Add(&prun);
+  reply.Add(&pupdated);
+  fPages[page].reset(new TMessage(kMESS_OBJECT));
+  fPages[page]->SetCompressionSettings(1);
+  fPages[page]->WriteObject(&reply);
+  reply.Clear();
+}
+
+//_____________________________________________________________________________
+void PageServer::Reply( TSocket* sock, const char* request )
+{
+  if( strncmp(request, "page ", 5) == 0 ) {
+    Int_t page = atoi(request + 5) - 1;
+    if( page >= 0 && page < static_cast<Int_t>(fPages.size()) &&
+        fPages[page] ) {
+      sock->Send(*fPages[page]);
+      return;
+    }
+  }
+  TMessage notok(kMESS_NOTOK);
+  sock->Send(notok);
+}
+
+//_____________________________________________________________________________
+void PageServer::Disconnect( TSocket* sock )
+{
+  fMonitor.Remove(sock);
+  fClients.erase(remove(fClients.begin(), fClients.end(), sock),
+                 fClients.end());
+  delete sock;
+}
+
+//_____________________________________________________________________________
+// Accept connections and answer requests for 'timeout' ms. With a timeout
+// of 0, only answer the requests that are already pending.
+void PageServer::Serve( Long_t timeout )
+{
+  if( !IsValid() ) {
+    gSystem->Sleep(timeout);
+    return;
+  }
+  Long64_t tend = static_cast<Long64_t>(gSystem->Now()) + timeout;
+  for( Long64_t wait = timeout; ;
+       wait = max(tend - static_cast<Long64_t>(gSystem->Now()), Long64_t(0)) ) {
+    TSocket* sock = fMonitor.Select(static_cast<Long_t>(wait));
+    if( !sock || sock == reinterpret_cast<TSocket*>(-1) )
+      break;  // Timeout
+    if( sock == fServer.get() ) {
+      if( TSocket* client = fServer->Accept() ) {
+        fMonitor.Add(client);
+        fClients.push_back(client);
+      }
+      continue;
+    }
+    char request[64];
+    if( sock->Recv(request, sizeof(request)) <= 0 )
+      Disconnect(sock);
+    else
+      Reply(sock, request);
+  }
+}
@@ -0,0 +1,128 @@
+///////////////////////////////////////////////////////////////////
+//  Shared filling of tree-draw histograms
+///////////////////////////////////////////////////////////////////
+
+#include "panguinShared.hh"
+#include <TH1F.h>
+#include <TEnv.h>
+
+using namespace std;
+
+//_____________________________________________________________________________
+SharedTreeFill::SharedTreeFill( TTree* tree )
+  : fTree{tree}
+{
+}
+
+//_____________________________________________________________________________
+// Returns the index of the compiled expression 'expr', compiling it if not
+// done yet. Returns -1 if it cannot be compiled or is not a scalar.
+Int_t SharedTreeFill::Compile( const TString& expr )
+{
+  string key = expr.Data();
+  auto it = fIndex.find(key);
+  if( it != fIndex.end() )
+    return it->second;
+  Int_t i = -1;
+  unique_ptr<TreeFormula> formula(
+    new TreeFormula(Form("shared%zu", fValues.size()), expr, fTree));
+  if( formula->GetNdim() > 0 && formula->GetMultiplicity() == 0 ) {
+    i = static_cast<Int_t>(fValues.size());
+    fValues.emplace_back();
+    fValues.back().formula = std::move(formula);
+  }
+  fIndex[key] = i;
+  return i;
+}
+
+//_____________________________________________________________________________
+// Add a 1D histogram of 'var' with 'cut' (a weight, as in TTree::Draw).
+// Returns the index of the histogram, or -1 if 'var' or 'cut' are not
+// supported, in which case the plot must be drawn the usual way.
+Int_t SharedTreeFill::Add( const TString& var, const TString& cut )
+{
+  // Only 1D: reject "y:x", but not scope operators like TMath::Abs
+  TString stripped = var;
+  stripped.ReplaceAll("::", "");
+  if( stripped.Contains(":") || var.Contains(">>") )
+    return -1;
+  Int_t ivar = Compile(var);
+  if( ivar < 0 )
+    return -1;
+  Int_t icut = -1;
+  if( !cut.IsNull() && (icut = Compile(cut)) < 0 )
+    return -1;
+
+  // Book the histogram like TTree::Draw: default binning, axis range
+  // determined from the first entries (buffer), drawing attributes of the tree
+  TString title = var;
+  if( !cut.IsNull() )
+    title += Form(" {%s}", cut.Data());
+  Int_t nbins = gEnv->GetValue("Hist.Binning.1D.x", 100);
+  Int_t i = GetSize();
+  unique_ptr<TH1> hist(new TH1F(Form("hshared_%d", i), title, nbins, 0, 0));
+  hist->SetDirectory(nullptr);
+  hist->SetCanExtend(TH1::kAllAxes);
+  hist->GetXaxis()->SetTitle(var);
+  fTree->TAttLine::Copy(*hist);
+  fTree->TAttFill::Copy(*hist);
+  fTree->TAttMarker::Copy(*hist);
+  fHists.emplace_back();
+  fHists.back().hist = std::move(hist);
+  fHists.back().var = ivar;
+  fHists.back().cut = icut;
+  return i;
+}
+
+//_____________________________________________________________________________
+// Value of expression 'i' for 'entry', which must be loaded
+Double_t SharedTreeFill::Eval( Int_t i, Long64_t entry )
+{
+  auto& val = fValues[i];
+  if( val.entry != entry ) {
+    val.formula->GetNdata();  // Loads the branches
+    val.value = val.formula->EvalInstance(0);
+    val.entry = entry;
+  }
+  return val.value;
+}
+
+//_____________________________________________________________________________
+// Fill all histograms from all tree entries. Returns the number of entries
+// read, or -1 on error.
+Long64_t SharedTreeFill::Run()
+{
+  if( fHists.empty() )
+    return 0;
+  Long64_t nentries = fTree->GetEntries();
+  Int_t treenumber = -1;
+  Long64_t entry = 0;
+  for( ; entry < nentries; ++entry ) {
+    if( fTree->LoadTree(entry) < 0 )
+      break;
+    if( fTree->GetTreeNumber() != treenumber ) {
+      // Next file of a TChain
+      treenumber = fTree->GetTreeNumber();
+      for( auto& val: fValues )
+        val.formula->UpdateFormulaLeaves();
+    }
+    for( auto& h: fHists ) {
+      Double_t w = (h.cut >= 0) ? Eval(h.cut, entry) : 1.;
+      if( w == 0 )
+        continue;
+      h.hist->Fill(Eval(h.var, entry), w);
+      ++h.nsel;
+    }
+  }
+  for( auto& h: fHists )
+    h.hist->BufferEmpty(1);
+  return entry;
+}
+
+//_____________________________________________________________________________
+// Hand over histogram 'i' to the caller, and its number of selected entries
+unique_ptr<TH1> SharedTreeFill::TakeHist( Int_t i, Long64_t& nsel )
+{
+  nsel = fHists[i].nsel;
+  return std::move(fHists[i].hist);
+}
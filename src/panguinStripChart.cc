@@ -0,0 +1,169 @@
+///////////////////////////////////////////////////////////////////
+//  Rolling-window strip charts of tree variables
+///////////////////////////////////////////////////////////////////
+
+#include "panguinStripChart.hh"
+#include "panguinDecimate.hh"
+#include <TDirectory.h>
+#include <algorithm>
+
+using namespace std;
+
+//_____________________________________________________________________________
+// Check for a "y:x" expression, ignoring scope operators like TMath::Abs
+static bool HasXExpression( const TString& expr )
+{
+  for( Ssiz_t i = 0; i < expr.Length(); ++i ) {
+    if( expr[i] == ':' ) {
+      if( i + 1 < expr.Length() && expr[i+1] == ':' )
+        ++i;
+      else
+        return true;
+    }
+  }
+  return false;
+}
+
+//_____________________________________________________________________________
+StripChart::StripChart( size_t capacity )
+  : fCapacity{max<size_t>(capacity, 2)}
+{
+}
+
+// Largest number of entries read at once, which bounds the memory needed
+static const Long64_t kMaxChunk = 100000;
+
+//_____________________________________________________________________________
+// Read the tree entries added since the last call and append the selected
+// values of 'expr' to the window. Returns the number of values read, or a
+// negative number on error (as TTree::Draw). With 'formulas', the compiled
+// expression is reused, since parsing it would take longer than reading
+// the few new entries.
+Long64_t StripChart::Update( TTree* tree, const TString& expr, const TCut& cut,
+                             FormulaCache* formulas )
+{
+  if( !tree )
+    return -1;
+  if( expr != fExpr || fCut != cut.GetTitle() ) {
+    Clear();
+    fExpr = expr;
+    fCut = cut.GetTitle();
+  }
+  Long64_t nentries = tree->GetEntries();
+  if( nentries < fNextEntry )
+    Clear();  // Tree was rewritten (new run)
+  if( nentries == fNextEntry )
+    return 0;
+
+  TString varexp = expr;
+  if( !HasXExpression(expr) )
+    varexp += ":Entry$";
+  TreeExpr* compiled = formulas ? formulas->Get(tree, varexp, cut.GetTitle())
+                                : nullptr;
+
+  // Read the new entries in chunks, backwards from the end of the tree,
+  // until the window is full. Older entries would fall out of it at once.
+  // With a cut or array expressions, the number of values per entry is not
+  // known, so the chunks grow until enough values are found.
+  vector<vector<double>> xs, ys;  // Values of each chunk, newest first
+  size_t nvalues = 0;
+  Long64_t last = nentries;
+  Long64_t chunk = min(static_cast<Long64_t>(fCapacity), kMaxChunk);
+  while( last > fNextEntry && nvalues < fCapacity ) {
+    Long64_t first = max(fNextEntry, last - chunk);
+    xs.emplace_back();
+    ys.emplace_back();
+    Long64_t nsel = Read(tree, varexp, cut, compiled, first, last - first,
+                         xs.back(), ys.back());
+    if( nsel < 0 )
+      return nsel;
+    nvalues += xs.back().size();
+    last = first;
+    chunk = min(2 * chunk, kMaxChunk);
+  }
+  for( size_t i = xs.size(); i-- > 0; )
+    Append(xs[i].data(), ys[i].data(), xs[i].size());
+  fNextEntry = nentries;
+  return static_cast<Long64_t>(nvalues);
+}
+
+//_____________________________________________________________________________
+// Append the values of 'varexp' ("y:x") for 'n' entries starting at 'first'
+// to 'x' and 'y'. Returns the number of selected values, or a negative
+// number on error.
+Long64_t StripChart::Read( TTree* tree, const TString& varexp, const TCut& cut,
+                           TreeExpr* compiled, Long64_t first, Long64_t n,
+                           vector<double>& x, vector<double>& y ) const
+{
+  if( compiled ) {
+    return compiled->Eval(first, n,
+      [&x, &y]( const Double_t* v, Double_t ) {
+        y.push_back(v[0]);
+        x.push_back(v[1]);
+      });
+  }
+
+  TString hname = Form("panguin_strip_%p", static_cast<const void*>(this));
+  Long64_t estimate = tree->GetEstimate();
+  tree->SetEstimate(n + 1);
+  Long64_t nsel = tree->Draw(varexp + ">>" + hname, cut, "goff", n, first);
+  if( nsel > 0 ) {
+    auto m = static_cast<size_t>(min(nsel, tree->GetEstimate()));
+    x.insert(x.end(), tree->GetV2(), tree->GetV2() + m);
+    y.insert(y.end(), tree->GetV1(), tree->GetV1() + m);
+  }
+  tree->SetEstimate(estimate);
+  delete gDirectory->Get(hname);
+  return nsel;
+}
+
+//_____________________________________________________________________________
+void StripChart::Append( const double* x, const double* y, size_t n )
+{
+  if( fX.size() != fCapacity ) {
+    fX.resize(fCapacity);
+    fY.resize(fCapacity);
+  }
+  if( n > fCapacity ) {
+    x += n - fCapacity;
+    y += n - fCapacity;
+    n = fCapacity;
+  }
+  for( size_t i = 0; i < n; ++i ) {
+    size_t pos = (fHead + fSize) % fCapacity;
+    fX[pos] = x[i];
+    fY[pos] = y[i];
+    if( fSize < fCapacity )
+      ++fSize;
+    else
+      fHead = (fHead + 1) % fCapacity;
+  }
+}
+
+//_____________________________________________________________________________
+// Return a graph of the current window, reduced to the minimum and maximum
+// per horizontal pixel if there are more points than 'npix' pixels can show
+TGraph* StripChart::GetGraph( size_t npix )
+{
+  vector<double> x(fSize), y(fSize);
+  for( size_t i = 0; i < fSize; ++i ) {
+    size_t pos = (fHead + i) % fCapacity;
+    x[i] = fX[pos];
+    y[i] = fY[pos];
+  }
+  auto keep = DecimateMinMax(y.data(), y.size(), npix);
+
+  if( !fGraph )
+    fGraph.reset(new TGraph);
+  fGraph->Set(static_cast<Int_t>(keep.size()));
+  for( size_t i = 0; i < keep.size(); ++i )
+    fGraph->SetPoint(static_cast<Int_t>(i), x[keep[i]], y[keep[i]]);
+  return fGraph.get();
+}
+
+//_____________________________________________________________________________
+void StripChart::Clear()
+{
+  fHead = fSize = 0;
+  fNextEntry = 0;
+}
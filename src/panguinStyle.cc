@@ -0,0 +1,57 @@
+///////////////////////////////////////////////////////////////////
+//  Per-page histogram style
+///////////////////////////////////////////////////////////////////
+
+#include "panguinStyle.hh"
+#include <TStyle.h>
+#include <TGaxis.h>
+#include <TROOT.h>
+
+//_____________________________________________________________________________
+PageStyle::PageStyle( bool logy, UInt_t draw_count )
+  : fLogy{logy}, fLabelSize{draw_count >= 8 ? 0.08f : 0.05f}
+{}
+
+//_____________________________________________________________________________
+// Make this the current style. Only sets values in gStyle; objects already
+// in memory are not touched.
+void PageStyle::Use() const
+{
+  gStyle->SetOptStat(1110);
+  gStyle->SetOptLogy(fLogy ? 1 : 0);
+  gStyle->SetTitleH(0.1);
+  gStyle->SetStatW(0.25);
+  gStyle->SetStatX(0.9);
+  gStyle->SetStatY(0.88);
+  gStyle->SetLabelSize(fLabelSize, "X");
+  gStyle->SetLabelSize(fLabelSize, "Y");
+  gStyle->SetPadLeftMargin(0.15);
+  gStyle->SetPadBottomMargin(0.08);
+  gStyle->SetPadRightMargin(0.1);
+  gStyle->SetPadTopMargin(0.12);
+  gStyle->SetNdivisions(505, "XYZ");
+  TGaxis::SetMaxDigits(3);
+}
+
+//_____________________________________________________________________________
+// Give 'hist', which may have been saved with a different style, the
+// current style, as gROOT->ForceStyle() would when reading it. Callers set
+// their own colors afterwards.
+void PageStyle::Apply( TH1* hist ) const
+{
+  if( hist )
+    hist->UseCurrentStyle();
+}
+
+//_____________________________________________________________________________
+ForcedStyle::ForcedStyle()
+  : fWasForced{gROOT->GetForceStyle()}
+{
+  gROOT->ForceStyle(kTRUE);
+}
+
+//_____________________________________________________________________________
+ForcedStyle::~ForcedStyle()
+{
+  gROOT->ForceStyle(fWasForced);
+}
@@ -0,0 +1,261 @@
+///////////////////////////////////////////////////////////////////
+//  Run-over-run trends of plot summaries
+///////////////////////////////////////////////////////////////////
+
+#include "panguinTrend.hh"
+#include <TFile.h>
+#include <TTree.h>
+#include <TF1.h>
+#include <TList.h>
+#include <TDirectory.h>
+#include <iostream>
+#include <memory>
+#include <cstdlib>
+#include <sys/stat.h>
+
+using namespace std;
+
+static const char* const kTrendTree = "trend";
+
+//_____________________________________________________________________________
+TrendStore::TrendStore( string file )
+  : fFile{std::move(file)}
+{
+}
+
+//_____________________________________________________________________________
+void TrendStore::SetFile( const string& file )
+{
+  if( file != fFile ) {
+    fFile = file;
+    fLoadTime = 0;
+    fData.clear();
+  }
+}
+
+//_____________________________________________________________________________
+// Extract the summary scalars of 'hist'. Fit results are taken from the
+// first fit function attached to the histogram.
+TrendSummary TrendStore::Summarize( const TH1* hist )
+{
+  TrendSummary sum;
+  sum.entries = hist->GetEntries();
+  sum.mean = hist->GetMean();
+  sum.meanerr = hist->GetMeanError();
+  sum.rms = hist->GetRMS();
+  sum.rmserr = hist->GetRMSError();
+  sum.integral = hist->Integral();
+  TIter next(hist->GetListOfFunctions());
+  while( auto* obj = next() ) {
+    if( auto* func = dynamic_cast<TF1*>(obj) ) {
+      sum.chi2 = func->GetChisquare();
+      sum.ndf = func->GetNDF();
+      for( Int_t i = 0; i < func->GetNpar(); ++i ) {
+        sum.par.push_back(func->GetParameter(i));
+        sum.parerr.push_back(func->GetParError(i));
+      }
+      break;
+    }
+  }
+  return sum;
+}
+
+//_____________________________________________________________________________
+// Queue the summary of plot 'name' for 'run'. It is shown in trend plots
+// right away and written to the store by Write().
+void TrendStore::Add( Int_t run, const string& name, const TrendSummary& sum )
+{
+  fPending[name][run] = sum;
+}
+
+//_____________________________________________________________________________
+// Append the queued summaries to the store file. Returns the number of
+// summaries written, or -1 on error.
+Int_t TrendStore::Write()
+{
+  if( fFile.empty() || fPending.empty() )
+    return 0;
+  unique_ptr<TFile> f(TFile::Open(fFile.c_str(), "UPDATE"));
+  if( !f || f->IsZombie() ) {
+    cerr << "Error opening trend file " << fFile << endl;
+    return -1;
+  }
+  Int_t run = 0;
+  UInt_t tstamp = static_cast<UInt_t>(time(nullptr));
+  string name, *pname = &name;
+  TrendSummary sum;
+  vector<Double_t> *ppar = &sum.par, *pparerr = &sum.parerr;
+
+  auto* tree = f->Get<TTree>(kTrendTree);
+  if( !tree ) {
+    TDirectory::TContext ctx(f.get());
+    tree = new TTree(kTrendTree, "panguin run-over-run plot summaries");
+    tree->Branch("run", &run, "run/I");
+    tree->Branch("time", &tstamp, "time/i");
+    tree->Branch("name", &pname);
+    tree->Branch("entries", &sum.entries, "entries/D");
+    tree->Branch("mean", &sum.mean, "mean/D");
+    tree->Branch("meanerr", &sum.meanerr, "meanerr/D");
+    tree->Branch("rms", &sum.rms, "rms/D");
+    tree->Branch("rmserr", &sum.rmserr, "rmserr/D");
+    tree->Branch("integral", &sum.integral, "integral/D");
+    tree->Branch("chi2", &sum.chi2, "chi2/D");
+    tree->Branch("ndf", &sum.ndf, "ndf/I");
+    tree->Branch("par", &ppar);
+    tree->Branch("parerr", &pparerr);
+  } else {
+    tree->SetBranchAddress("run", &run);
+    tree->SetBranchAddress("time", &tstamp);
+    tree->SetBranchAddress("name", &pname);
+    tree->SetBranchAddress("entries", &sum.entries);
+    tree->SetBranchAddress("mean", &sum.mean);
+    tree->SetBranchAddress("meanerr", &sum.meanerr);
+    tree->SetBranchAddress("rms", &sum.rms);
+    tree->SetBranchAddress("rmserr", &sum.rmserr);
+    tree->SetBranchAddress("integral", &sum.integral);
+    tree->SetBranchAddress("chi2", &sum.chi2);
+    tree->SetBranchAddress("ndf", &sum.ndf);
+    tree->SetBranchAddress("par", &ppar);
+    tree->SetBranchAddress("parerr", &pparerr);
+  }
+  Int_t nwritten = 0;
+  for( const auto& item: fPending ) {
+    name = item.first;
+    for( const auto& entry: item.second ) {
+      run = entry.first;
+      sum = entry.second;
+      tree->Fill();
+      ++nwritten;
+    }
+  }
+  tree->Write("", TObject::kOverwrite);
+  tree->ResetBranchAddresses();
+  f->Close();
+
+  // Keep what was written without rereading the file
+  for( auto& item: fPending ) {
+    for( auto& entry: item.second )
+      fData[item.first][entry.first] = std::move(entry.second);
+  }
+  fPending.clear();
+  struct stat buf{};
+  if( stat(fFile.c_str(), &buf) == 0 )
+    fLoadTime = buf.st_mtime;
+  return nwritten;
+}
+
+//_____________________________________________________________________________
+// (Re)read the store if the file changed since the last read. If a run
+// appears several times (reprocessed), the last entry wins.
+void TrendStore::Load()
+{
+  struct stat buf{};
+  if( fFile.empty() || stat(fFile.c_str(), &buf) != 0 ||
+      buf.st_mtime == fLoadTime )
+    return;
+  fLoadTime = buf.st_mtime;
+  fData.clear();
+
+  unique_ptr<TFile> f(TFile::Open(fFile.c_str(), "READ"));
+  auto* tree = (f && !f->IsZombie()) ? f->Get<TTree>(kTrendTree) : nullptr;
+  if( !tree ) {
+    cerr << "No trend data in " << fFile << endl;
+    return;
+  }
+  Int_t run = 0;
+  string name, *pname = &name;
+  TrendSummary sum;
+  vector<Double_t> *ppar = &sum.par, *pparerr = &sum.parerr;
+  tree->SetBranchAddress("run", &run);
+  tree->SetBranchAddress("name", &pname);
+  tree->SetBranchAddress("entries", &sum.entries);
+  tree->SetBranchAddress("mean", &sum.mean);
+  tree->SetBranchAddress("meanerr", &sum.meanerr);
+  tree->SetBranchAddress("rms", &sum.rms);
+  tree->SetBranchAddress("rmserr", &sum.rmserr);
+  tree->SetBranchAddress("integral", &sum.integral);
+  tree->SetBranchAddress("chi2", &sum.chi2);
+  tree->SetBranchAddress("ndf", &sum.ndf);
+  tree->SetBranchAddress("par", &ppar);
+  tree->SetBranchAddress("parerr", &pparerr);
+  for( Long64_t i = 0; i < tree->GetEntries(); ++i ) {
+    tree->GetEntry(i);
+    fData[name][run] = sum;
+  }
+  tree->ResetBranchAddresses();
+}
+
+//_____________________________________________________________________________
+// Value and error of 'quantity' in 'sum': "entries", "mean", "rms",
+// "integral", "chi2" (per degree of freedom of the fit) or "pN" (fit
+// parameter N). Returns false if the quantity is unknown or unavailable.
+bool TrendStore::GetValue( const TrendSummary& sum, const string& quantity,
+                           Double_t& val, Double_t& err )
+{
+  err = 0;
+  if( quantity == "entries" ) {
+    val = sum.entries;
+  } else if( quantity == "mean" ) {
+    val = sum.mean;
+    err = sum.meanerr;
+  } else if( quantity == "rms" ) {
+    val = sum.rms;
+    err = sum.rmserr;
+  } else if( quantity == "integral" ) {
+    val = sum.integral;
+  } else if( quantity == "chi2" ) {
+    if( sum.ndf <= 0 )
+      return false;
+    val = sum.chi2 / sum.ndf;
+  } else if( quantity.size() > 1 && quantity[0] == 'p' &&
+             quantity.find_first_not_of("0123456789", 1) == string::npos ) {
+    auto ipar = strtoul(quantity.c_str() + 1, nullptr, 10);
+    if( ipar >= sum.par.size() )
+      return false;
+    val = sum.par[ipar];
+    err = sum.parerr[ipar];
+  } else {
+    return false;
+  }
+  return true;
+}
+
+//_____________________________________________________________________________
+// Graph of 'quantity' of plot 'name' vs. run number, for the last 'maxruns'
+// runs (0 = all) in the store and those added since. The graph is owned by
+// the caller. Returns nullptr if there are no data.
+TGraphErrors* TrendStore::MakeGraph( const string& name, const string& quantity,
+                                     size_t maxruns )
+{
+  Load();
+  RunMap_t runs;
+  auto it = fData.find(name);
+  if( it != fData.end() )
+    runs = it->second;
+  auto jt = fPending.find(name);
+  if( jt != fPending.end() ) {
+    for( const auto& entry: jt->second )
+      runs[entry.first] = entry.second;
+  }
+
+  vector<Double_t> x, y, ey;
+  for( auto rt = runs.rbegin(); rt != runs.rend(); ++rt ) {
+    if( maxruns > 0 && x.size() >= maxruns )
+      break;
+    Double_t val = 0, err = 0;
+    if( GetValue(rt->second, quantity, val, err) ) {
+      x.push_back(rt->first);
+      y.push_back(val);
+      ey.push_back(err);
+    }
+  }
+  if( x.empty() )
+    return nullptr;
+  auto n = static_cast<Int_t>(x.size());
+  auto* graph = new TGraphErrors(n);
+  for( Int_t i = 0; i < n; ++i ) {
+    graph->SetPoint(i, x[n - 1 - i], y[n - 1 - i]);
+    graph->SetPointError(i, 0, ey[n - 1 - i]);
+  }
+  return graph;
+}